@@ -47,11 +47,21 @@ extern "C"
 #include <time.h>
 #endif
 
+// ----------------------------------------------------------------
+// Expected failure assertions
+// ----------------------------------------------------------------
+#define TEST_ASSERT_FAILS(check) \
+do { \
+    xtest_failure_begin(); \
+    check; \
+    TEST_ASSERT(xtest_failure_end(), "Check was expected to fail"); \
+} while (false)
+
 // ----------------------------------------------------------------
 // Memory assertions
 // ----------------------------------------------------------------
-#define TEST_ASSERT_EQUAL_MEMORY(actual, expected, size)     TEST_ASSERT(memcmp(actual, expected, size) != 0, "Expectation for memory equality not met")
-#define TEST_ASSERT_NOT_EQUAL_MEMORY(actual, expected, size) TEST_ASSERT(memcmp(actual, expected, size) == 0, "Expectation for memory inequality not met")
+#define TEST_ASSERT_EQUAL_MEMORY(actual, expected, size)     TEST_ASSERT(memcmp(actual, expected, size) == 0, "Expectation for memory equality not met")
+#define TEST_ASSERT_NOT_EQUAL_MEMORY(actual, expected, size) TEST_ASSERT(memcmp(actual, expected, size) != 0, "Expectation for memory inequality not met")
 #define TEST_ASSERT_CONTAINS_MEMORY(haystack, needle, haystackSize, needleSize) \
 bool found = false; \
 for (size_t i = 0; i <= (haystackSize - needleSize); i++) { \
@@ -60,7 +70,7 @@ for (size_t i = 0; i <= (haystackSize - needleSize); i++) { \
         break; \
     } \
 } \
-TEST_ASSERT(!found, "Memory contains assertion failed");
+TEST_ASSERT(found, "Memory contains assertion failed");
 
 #define TEST_ASSERT_NOT_CONTAINS_MEMORY(haystack, needle, haystackSize, needleSize) \
 bool found = false; \
@@ -70,7 +80,7 @@ for (size_t i = 0; i <= (haystackSize - needleSize); i++) { \
         break; \
     } \
 } \
-TEST_ASSERT(found, "Memory not contains assertion failed");
+TEST_ASSERT(!found, "Memory not contains assertion failed");
 
 #define TEST_ASSERT_COPIED_MEMORY(dest, source, size)     TEST_ASSERT((memcmp(dest, source, size) == 0), "Memory copy check failed");
 #define TEST_ASSERT_NOT_COPIED_MEMORY(dest, source, size) TEST_ASSERT((memcmp(dest, source, size) != 0), "Memory not copied check failed");
@@ -82,19 +92,19 @@ TEST_ASSERT(found, "Memory not contains assertion failed");
 #define TEST_ASSERT_NOT_EQUAL(actual, expected) TEST_ASSERT((bool)(actual) != (bool)(expected), "Expectation for inequality not met")
 #define TEST_ASSERT_LESS(actual, expected)      TEST_ASSERT((bool)(actual) <  (bool)(expected), "Expectation for less than not met")
 #define TEST_ASSERT_GREATER(actual, expected)   TEST_ASSERT((bool)(actual) >  (bool)(expected), "Expectation for greater than not met")
-#define TEST_ASSERT_UNLESS(expression)          TEST_ASSERT((expression), "Expectation not met")
+#define TEST_ASSERT_UNLESS(expression)          TEST_ASSERT(!(expression), "Expectation not met")
 #define TEST_ASSERT_TRUE(expression)            TEST_ASSERT((expression), "Expectation for true not met")
 #define TEST_ASSERT_FALSE(expression)           TEST_ASSERT(!(expression), "Expectation for false not met")
-#define TEST_ASSERT_MSG(expression, message)    TEST_ASSERT(!(expression), message)
+#define TEST_ASSERT_MSG(expression, message)    TEST_ASSERT(expression, message)
 
 #define TEST_ASSERT_EQUAL_BOOL(actual, expected)     TEST_ASSERT((bool)(actual) == (bool)(expected), "Expectation for equality not met")
 #define TEST_ASSERT_NOT_EQUAL_BOOL(actual, expected) TEST_ASSERT((bool)(actual) != (bool)(expected), "Expectation for inequality not met")
 #define TEST_ASSERT_LESS_BOOL(actual, expected)      TEST_ASSERT((bool)(actual) <  (bool)(expected), "Expectation for less than not met")
 #define TEST_ASSERT_GREATER_BOOL(actual, expected)   TEST_ASSERT((bool)(actual) >  (bool)(expected), "Expectation for greater than not met")
-#define TEST_ASSERT_UNLESS_BOOL(expression)          TEST_ASSERT((expression), "Expectation not met")
+#define TEST_ASSERT_UNLESS_BOOL(expression)          TEST_ASSERT(!(expression), "Expectation not met")
 #define TEST_ASSERT_TRUE_BOOL(expression)            TEST_ASSERT((expression), "Expectation for true not met")
 #define TEST_ASSERT_FALSE_BOOL(expression)           TEST_ASSERT(!(expression), "Expectation for false not met")
-#define TEST_ASSERT_MSG_BOOL(expression, message)    TEST_ASSERT(!(expression), message)
+#define TEST_ASSERT_MSG_BOOL(expression, message)    TEST_ASSERT(expression, message)
 
 // ----------------------------------------------------------------
 // Enum assertions
@@ -281,15 +291,15 @@ TEST_ASSERT(found, "Memory not contains assertion failed");
 #define TEST_ASSERT_OCT_WITHIN(actual, expected, tolerance)     TEST_ASSERT(((signed)(actual) >= ((signed)(expected) - (signed)(tolerance))) && ((signed)(actual) <= ((signed)(expected) + (signed)(tolerance))), "Octal value not within tolerance")
 #define TEST_ASSERT_FLOAT_WITHIN(actual, expected, epsilon)     TEST_ASSERT(fabs((float)(actual) - (float)(expected)) <= (float)(epsilon), "Float value not within epsilon")
 #define TEST_ASSERT_DOUBLE_WITHIN(actual, expected, epsilon)    TEST_ASSERT(fabs((double)(actual) - (double)(expected)) <= (double)(epsilon), "Double value not within epsilon")
-#define TEST_ASSERT_CHAR_WITHIN(actual, min, max)               TEST_ASSERT((actual) > (min) || (actual) < (max), "Character value not within range")
-#define TEST_ASSERT_WCHAR_WITHIN(actual, min, max)              TEST_ASSERT((actual) > (min) || (actual) < (max), "W-Character value not within range")
+#define TEST_ASSERT_CHAR_WITHIN(actual, min, max)               TEST_ASSERT((actual) >= (min) && (actual) <= (max), "Character value not within range")
+#define TEST_ASSERT_WCHAR_WITHIN(actual, min, max)              TEST_ASSERT((actual) >= (min) && (actual) <= (max), "W-Character value not within range")
 
 // ----------------------------------------------------------------
 // Float assertions
 // ----------------------------------------------------------------
 #ifdef __cplusplus
 #define TEST_ASSERT_FLOAT_EQUAL(actual, expected)         TEST_ASSERT(std::fabs((float)(actual) -  (float)(expected)) < XTEST_FLOAT_EPSILON, "Floating-point value not equal within epsilon")
-#define TEST_ASSERT_FLOAT_NOT_EQUAL(actual, expected)     TEST_ASSERT(std::fabs((float)(actual) -  (float)(expected)) <= XTEST_FLOAT_EPSILON, "Floating-point value equal within epsilon")
+#define TEST_ASSERT_FLOAT_NOT_EQUAL(actual, expected)     TEST_ASSERT(std::fabs((float)(actual) -  (float)(expected)) > XTEST_FLOAT_EPSILON, "Floating-point value equal within epsilon")
 #define TEST_ASSERT_FLOAT_LESS(actual, expected)          TEST_ASSERT((float)(actual)      <  (float)(expected),   "Floating-point value not less")
 #define TEST_ASSERT_FLOAT_GREATER(actual, expected)       TEST_ASSERT((float)(actual)      >  (float)(expected),   "Floating-point value not greater")
 #define TEST_ASSERT_FLOAT_GREATER_EQUAL(actual, expected) TEST_ASSERT((float)(actual)      >= (float)(expected),   "Floating-point value not greater or equal")
@@ -306,7 +316,7 @@ TEST_ASSERT(found, "Memory not contains assertion failed");
 #define TEST_ASSERT_FLOAT_IS_NOT_DETERMINATE(actual)     TEST_ASSERT(std::isnan((float)actual)  || std::isinf((float)actual),    "Floating-precision value deterministic")
 #else
 #define TEST_ASSERT_FLOAT_EQUAL(actual, expected)         TEST_ASSERT(fabs((float)(actual) -  (float)(expected)) < XTEST_FLOAT_EPSILON, "Floating-point value not equal within epsilon")
-#define TEST_ASSERT_FLOAT_NOT_EQUAL(actual, expected)     TEST_ASSERT(fabs((float)(actual) -  (float)(expected)) <= XTEST_FLOAT_EPSILON, "Floating-point value equal within epsilon")
+#define TEST_ASSERT_FLOAT_NOT_EQUAL(actual, expected)     TEST_ASSERT(fabs((float)(actual) -  (float)(expected)) > XTEST_FLOAT_EPSILON, "Floating-point value equal within epsilon")
 #define TEST_ASSERT_FLOAT_LESS(actual, expected)          TEST_ASSERT((float)(actual)      <  (float)(expected),   "Floating-point value not less")
 #define TEST_ASSERT_FLOAT_GREATER(actual, expected)       TEST_ASSERT((float)(actual)      >  (float)(expected),   "Floating-point value not greater")
 #define TEST_ASSERT_FLOAT_GREATER_EQUAL(actual, expected) TEST_ASSERT((float)(actual)      >= (float)(expected),   "Floating-point value not greater or equal")
@@ -328,7 +338,7 @@ TEST_ASSERT(found, "Memory not contains assertion failed");
 // ----------------------------------------------------------------
 #ifdef __cplusplus
 #define TEST_ASSERT_DOUBLE_EQUAL(actual, expected)         TEST_ASSERT(std::fabs((double)(actual) - (double)(expected)) <  XTEST_DOUBLE_EPSILON, "Double-precision value not equal within epsilon")
-#define TEST_ASSERT_DOUBLE_NOT_EQUAL(actual, expected)     TEST_ASSERT(std::fabs((double)(actual) - (double)(expected)) <= XTEST_DOUBLE_EPSILON, "Double-precision value equal within epsilon")
+#define TEST_ASSERT_DOUBLE_NOT_EQUAL(actual, expected)     TEST_ASSERT(std::fabs((double)(actual) - (double)(expected)) > XTEST_DOUBLE_EPSILON, "Double-precision value equal within epsilon")
 #define TEST_ASSERT_DOUBLE_LESS(actual, expected)          TEST_ASSERT((double)(actual) <  (double)(expected), "Double-precision value not less")
 #define TEST_ASSERT_DOUBLE_GREATER(actual, expected)       TEST_ASSERT((double)(actual) >  (double)(expected), "Double-precision value not greater")
 #define TEST_ASSERT_DOUBLE_GREATER_EQUAL(actual, expected) TEST_ASSERT((double)(actual) >= (double)(expected), "Double-precision value not greater or equal")
@@ -345,7 +355,7 @@ TEST_ASSERT(found, "Memory not contains assertion failed");
 #define TEST_ASSERT_DOUBLE_IS_NOT_DETERMINATE(actual)      TEST_ASSERT(std::isnan((double)actual)  || std::isinf((double)actual),    "Double-precision value deterministic")
 #else
 #define TEST_ASSERT_DOUBLE_EQUAL(actual, expected)         TEST_ASSERT(fabs((double)(actual) - (double)(expected)) <  XTEST_DOUBLE_EPSILON, "Double-precision value not equal within epsilon")
-#define TEST_ASSERT_DOUBLE_NOT_EQUAL(actual, expected)     TEST_ASSERT(fabs((double)(actual) - (double)(expected)) <= XTEST_DOUBLE_EPSILON, "Double-precision value equal within epsilon")
+#define TEST_ASSERT_DOUBLE_NOT_EQUAL(actual, expected)     TEST_ASSERT(fabs((double)(actual) - (double)(expected)) > XTEST_DOUBLE_EPSILON, "Double-precision value equal within epsilon")
 #define TEST_ASSERT_DOUBLE_LESS(actual, expected)          TEST_ASSERT((double)(actual) <  (double)(expected), "Double-precision value not less")
 #define TEST_ASSERT_DOUBLE_GREATER(actual, expected)       TEST_ASSERT((double)(actual) >  (double)(expected), "Double-precision value not greater")
 #define TEST_ASSERT_DOUBLE_GREATER_EQUAL(actual, expected) TEST_ASSERT((double)(actual) >= (double)(expected), "Double-precision value not greater or equal")
@@ -398,9 +408,9 @@ TEST_ASSERT(found, "Memory not contains assertion failed");
 #define TEST_ASSERT_CONTAINS_SUBSTRING_STRING(string, substring) TEST_ASSERT(strstr((string), (substring)) != nullptr, "Substring not found")
 #define TEST_ASSERT_NOT_CONTAINS_SUBSTRING_STRING(string, substring) TEST_ASSERT(strstr((string), (substring)) == nullptr, "Substring found")
 #define TEST_ASSERT_STARTS_WITH_STRING(string, prefix) TEST_ASSERT(strncmp((string), (prefix), strlen(prefix)) == 0, "String doesn't start with the prefix")
-#define TEST_ASSERT_ENDS_WITH_STRING(string, suffix) TEST_ASSERT(strstr((string), (suffix) != nullptr && (strlen(string) - strlen(suffix)) == (strstr(string, suffix) - string)), "String doesn't end with the suffix")
-#define TEST_ASSERT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
-#define TEST_ASSERT_NOT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
+#define TEST_ASSERT_ENDS_WITH_STRING(string, suffix) TEST_ASSERT((strstr(string, suffix) != nullptr && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix) == 0), "String doesn't end with the suffix")
+#define TEST_ASSERT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_ASSERT(xtest_strcasecmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
+#define TEST_ASSERT_NOT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_ASSERT(xtest_strcasecmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
 
 #define TEST_ASSERT_EQUAL_CSTRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) == 0, "String equality expectation not met")
 #define TEST_ASSERT_NOT_EQUAL_CSTRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) != 0, "String inequality expectation not met")
@@ -408,9 +418,9 @@ TEST_ASSERT(found, "Memory not contains assertion failed");
 #define TEST_ASSERT_CONTAINS_SUBSTRING_CSTRING(string, substring) TEST_ASSERT(strstr((string), (substring)) != NULL, "Substring not found")
 #define TEST_ASSERT_NOT_CONTAINS_SUBSTRING_CSTRING(string, substring) TEST_ASSERT(strstr((string), (substring)) == NULL, "Substring found")
 #define TEST_ASSERT_STARTS_WITH_CSTRING(string, prefix) TEST_ASSERT(strncmp((string), (prefix), strlen(prefix)) == 0, "String doesn't start with the prefix")
-#define TEST_ASSERT_ENDS_WITH_CSTRING(string, suffix) TEST_ASSERT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix)), "String doesn't end with the suffix")
-#define TEST_ASSERT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
-#define TEST_ASSERT_NOT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
+#define TEST_ASSERT_ENDS_WITH_CSTRING(string, suffix) TEST_ASSERT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix) == 0), "String doesn't end with the suffix")
+#define TEST_ASSERT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_ASSERT(xtest_strcasecmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
+#define TEST_ASSERT_NOT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_ASSERT(xtest_strcasecmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
 #else
 #define TEST_ASSERT_EQUAL_CSTRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) == 0, "String equality expectation not met")
 #define TEST_ASSERT_NOT_EQUAL_CSTRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) != 0, "String inequality expectation not met")
@@ -418,9 +428,9 @@ TEST_ASSERT(found, "Memory not contains assertion failed");
 #define TEST_ASSERT_CONTAINS_SUBSTRING_CSTRING(string, substring) TEST_ASSERT(strstr((string), (substring)) != NULL, "Substring not found")
 #define TEST_ASSERT_NOT_CONTAINS_SUBSTRING_CSTRING(string, substring) TEST_ASSERT(strstr((string), (substring)) == NULL, "Substring found")
 #define TEST_ASSERT_STARTS_WITH_CSTRING(string, prefix) TEST_ASSERT(strncmp((string), (prefix), strlen(prefix)) == 0, "String doesn't start with the prefix")
-#define TEST_ASSERT_ENDS_WITH_CSTRING(string, suffix) TEST_ASSERT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix)), "String doesn't end with the suffix")
-#define TEST_ASSERT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
-#define TEST_ASSERT_NOT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
+#define TEST_ASSERT_ENDS_WITH_CSTRING(string, suffix) TEST_ASSERT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix) == 0), "String doesn't end with the suffix")
+#define TEST_ASSERT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_ASSERT(xtest_strcasecmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
+#define TEST_ASSERT_NOT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_ASSERT(xtest_strcasecmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
 
 #define TEST_ASSERT_EQUAL_STRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) == 0, "String equality expectation not met")
 #define TEST_ASSERT_NOT_EQUAL_STRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) != 0, "String inequality expectation not met")
@@ -428,9 +438,9 @@ TEST_ASSERT(found, "Memory not contains assertion failed");
 #define TEST_ASSERT_CONTAINS_SUBSTRING_STRING(string, substring) TEST_ASSERT(strstr((string), (substring)) != NULL, "Substring not found")
 #define TEST_ASSERT_NOT_CONTAINS_SUBSTRING_STRING(string, substring) TEST_ASSERT(strstr((string), (substring)) == NULL, "Substring found")
 #define TEST_ASSERT_STARTS_WITH_STRING(string, prefix) TEST_ASSERT(strncmp((string), (prefix), strlen(prefix)) == 0, "String doesn't start with the prefix")
-#define TEST_ASSERT_ENDS_WITH_STRING(string, suffix) TEST_ASSERT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix)), "String doesn't end with the suffix")
-#define TEST_ASSERT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
-#define TEST_ASSERT_NOT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_ASSERT(strcmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
+#define TEST_ASSERT_ENDS_WITH_STRING(string, suffix) TEST_ASSERT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix) == 0), "String doesn't end with the suffix")
+#define TEST_ASSERT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_ASSERT(xtest_strcasecmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
+#define TEST_ASSERT_NOT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_ASSERT(xtest_strcasecmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
 #endif
 
 // ----------------------------------------------------------------
@@ -47,11 +47,21 @@ extern "C"
 #include <time.h>
 #endif
 
+// ----------------------------------------------------------------
+// Expected failure expectations
+// ----------------------------------------------------------------
+#define TEST_EXPECT_FAILS(check) \
+do { \
+    xtest_failure_begin(); \
+    check; \
+    TEST_EXPECT(xtest_failure_end(), "Check was expected to fail"); \
+} while (false)
+
 // ----------------------------------------------------------------
 // Memory assertions
 // ----------------------------------------------------------------
-#define TEST_EXPECT_EQUAL_MEMORY(actual, expected, size)     TEST_EXPECT(memcmp(actual, expected, size) != 0, "Expectation for memory equality not met")
-#define TEST_EXPECT_NOT_EQUAL_MEMORY(actual, expected, size) TEST_EXPECT(memcmp(actual, expected, size) == 0, "Expectation for memory inequality not met")
+#define TEST_EXPECT_EQUAL_MEMORY(actual, expected, size)     TEST_EXPECT(memcmp(actual, expected, size) == 0, "Expectation for memory equality not met")
+#define TEST_EXPECT_NOT_EQUAL_MEMORY(actual, expected, size) TEST_EXPECT(memcmp(actual, expected, size) != 0, "Expectation for memory inequality not met")
 #define TEST_EXPECT_CONTAINS_MEMORY(haystack, needle, haystackSize, needleSize) \
 bool found = false; \
 for (size_t i = 0; i <= (haystackSize - needleSize); i++) { \
@@ -60,7 +70,7 @@ for (size_t i = 0; i <= (haystackSize - needleSize); i++) { \
         break; \
     } \
 } \
-TEST_EXPECT(!found, "Memory contains assertion failed");
+TEST_EXPECT(found, "Memory contains assertion failed");
 
 #define TEST_EXPECT_NOT_CONTAINS_MEMORY(haystack, needle, haystackSize, needleSize) \
 bool found = false; \
@@ -70,7 +80,7 @@ for (size_t i = 0; i <= (haystackSize - needleSize); i++) { \
         break; \
     } \
 } \
-TEST_EXPECT(found, "Memory not contains assertion failed");
+TEST_EXPECT(!found, "Memory not contains assertion failed");
 
 #define TEST_EXPECT_COPIED_MEMORY(dest, source, size)     TEST_EXPECT((memcmp(dest, source, size) == 0), "Memory copy check failed");
 #define TEST_EXPECT_NOT_COPIED_MEMORY(dest, source, size) TEST_EXPECT((memcmp(dest, source, size) != 0), "Memory not copied check failed");
@@ -82,19 +92,19 @@ TEST_EXPECT(found, "Memory not contains assertion failed");
 #define TEST_EXPECT_NOT_EQUAL(actual, expected) TEST_EXPECT((bool)(actual) != (bool)(expected), "Expectation for inequality not met")
 #define TEST_EXPECT_LESS(actual, expected)      TEST_EXPECT((bool)(actual) <  (bool)(expected), "Expectation for less than not met")
 #define TEST_EXPECT_GREATER(actual, expected)   TEST_EXPECT((bool)(actual) >  (bool)(expected), "Expectation for greater than not met")
-#define TEST_EXPECT_UNLESS(expression)          TEST_EXPECT((expression), "Expectation not met")
+#define TEST_EXPECT_UNLESS(expression)          TEST_EXPECT(!(expression), "Expectation not met")
 #define TEST_EXPECT_TRUE(expression)            TEST_EXPECT((expression), "Expectation for true not met")
 #define TEST_EXPECT_FALSE(expression)           TEST_EXPECT(!(expression), "Expectation for false not met")
-#define TEST_EXPECT_MSG(expression, message)    TEST_EXPECT(!(expression), message)
+#define TEST_EXPECT_MSG(expression, message)    TEST_EXPECT(expression, message)
 
 #define TEST_EXPECT_EQUAL_BOOL(actual, expected)     TEST_EXPECT((bool)(actual) == (bool)(expected), "Expectation for equality not met")
 #define TEST_EXPECT_NOT_EQUAL_BOOL(actual, expected) TEST_EXPECT((bool)(actual) != (bool)(expected), "Expectation for inequality not met")
 #define TEST_EXPECT_LESS_BOOL(actual, expected)      TEST_EXPECT((bool)(actual) <  (bool)(expected), "Expectation for less than not met")
 #define TEST_EXPECT_GREATER_BOOL(actual, expected)   TEST_EXPECT((bool)(actual) >  (bool)(expected), "Expectation for greater than not met")
-#define TEST_EXPECT_UNLESS_BOOL(expression)          TEST_EXPECT((expression), "Expectation not met")
+#define TEST_EXPECT_UNLESS_BOOL(expression)          TEST_EXPECT(!(expression), "Expectation not met")
 #define TEST_EXPECT_TRUE_BOOL(expression)            TEST_EXPECT((expression), "Expectation for true not met")
 #define TEST_EXPECT_FALSE_BOOL(expression)           TEST_EXPECT(!(expression), "Expectation for false not met")
-#define TEST_EXPECT_MSG_BOOL(expression, message)    TEST_EXPECT(!(expression), message)
+#define TEST_EXPECT_MSG_BOOL(expression, message)    TEST_EXPECT(expression, message)
 
 // ----------------------------------------------------------------
 // Enum assertions
@@ -283,15 +293,15 @@ TEST_EXPECT(found, "Memory not contains assertion failed");
 #define TEST_EXPECT_FLOAT_WITHIN(actual, expected, epsilon)     TEST_EXPECT(fabs((float)(actual) - (float)(expected)) <= (float)(epsilon), "Float value not within epsilon")
 #define TEST_EXPECT_DOUBLE_WITHIN(actual, expected, epsilon)    TEST_EXPECT(fabs((double)(actual) - (double)(expected)) <= (double)(epsilon), "Double value not within epsilon")
 
-#define TEST_EXPECT_CHAR_WITHIN(actual, min, max)               TEST_EXPECT((actual) > (min) || (actual) < (max), "Character value not within range")
-#define TEST_EXPECT_WCHAR_WITHIN(actual, min, max)              TEST_EXPECT((actual) > (min) || (actual) < (max), "W-Character value not within range")
+#define TEST_EXPECT_CHAR_WITHIN(actual, min, max)               TEST_EXPECT((actual) >= (min) && (actual) <= (max), "Character value not within range")
+#define TEST_EXPECT_WCHAR_WITHIN(actual, min, max)              TEST_EXPECT((actual) >= (min) && (actual) <= (max), "W-Character value not within range")
 
 // ----------------------------------------------------------------
 // Float assertions
 // ----------------------------------------------------------------
 #ifdef __cplusplus
 #define TEST_EXPECT_FLOAT_EQUAL(actual, expected)         TEST_EXPECT(std::fabs((float)(actual) -  (float)(expected)) < XTEST_FLOAT_EPSILON, "Floating-point value not equal within epsilon")
-#define TEST_EXPECT_FLOAT_NOT_EQUAL(actual, expected)     TEST_EXPECT(std::fabs((float)(actual) -  (float)(expected)) <= XTEST_FLOAT_EPSILON, "Floating-point value equal within epsilon")
+#define TEST_EXPECT_FLOAT_NOT_EQUAL(actual, expected)     TEST_EXPECT(std::fabs((float)(actual) -  (float)(expected)) > XTEST_FLOAT_EPSILON, "Floating-point value equal within epsilon")
 #define TEST_EXPECT_FLOAT_LESS(actual, expected)          TEST_EXPECT((float)(actual)      <  (float)(expected),   "Floating-point value not less")
 #define TEST_EXPECT_FLOAT_GREATER(actual, expected)       TEST_EXPECT((float)(actual)      >  (float)(expected),   "Floating-point value not greater")
 #define TEST_EXPECT_FLOAT_GREATER_EQUAL(actual, expected) TEST_EXPECT((float)(actual)      >= (float)(expected),   "Floating-point value not greater or equal")
@@ -308,7 +318,7 @@ TEST_EXPECT(found, "Memory not contains assertion failed");
 #define TEST_EXPECT_FLOAT_IS_NOT_DETERMINATE(actual)     TEST_EXPECT(std::isnan((float)actual)  || std::isinf((float)actual),    "Floating-precision value deterministic")
 #else
 #define TEST_EXPECT_FLOAT_EQUAL(actual, expected)         TEST_EXPECT(fabs((float)(actual) -  (float)(expected)) < XTEST_FLOAT_EPSILON, "Floating-point value not equal within epsilon")
-#define TEST_EXPECT_FLOAT_NOT_EQUAL(actual, expected)     TEST_EXPECT(fabs((float)(actual) -  (float)(expected)) <= XTEST_FLOAT_EPSILON, "Floating-point value equal within epsilon")
+#define TEST_EXPECT_FLOAT_NOT_EQUAL(actual, expected)     TEST_EXPECT(fabs((float)(actual) -  (float)(expected)) > XTEST_FLOAT_EPSILON, "Floating-point value equal within epsilon")
 #define TEST_EXPECT_FLOAT_LESS(actual, expected)          TEST_EXPECT((float)(actual)      <  (float)(expected),   "Floating-point value not less")
 #define TEST_EXPECT_FLOAT_GREATER(actual, expected)       TEST_EXPECT((float)(actual)      >  (float)(expected),   "Floating-point value not greater")
 #define TEST_EXPECT_FLOAT_GREATER_EQUAL(actual, expected) TEST_EXPECT((float)(actual)      >= (float)(expected),   "Floating-point value not greater or equal")
@@ -330,7 +340,7 @@ TEST_EXPECT(found, "Memory not contains assertion failed");
 // ----------------------------------------------------------------
 #ifdef __cplusplus
 #define TEST_EXPECT_DOUBLE_EQUAL(actual, expected)         TEST_EXPECT(fabs((double)(actual) - (double)(expected)) <  XTEST_DOUBLE_EPSILON, "Double-precision value not equal within epsilon")
-#define TEST_EXPECT_DOUBLE_NOT_EQUAL(actual, expected)     TEST_EXPECT(fabs((double)(actual) - (double)(expected)) <= XTEST_DOUBLE_EPSILON, "Double-precision value equal within epsilon")
+#define TEST_EXPECT_DOUBLE_NOT_EQUAL(actual, expected)     TEST_EXPECT(fabs((double)(actual) - (double)(expected)) > XTEST_DOUBLE_EPSILON, "Double-precision value equal within epsilon")
 #define TEST_EXPECT_DOUBLE_LESS(actual, expected)          TEST_EXPECT((double)(actual) <  (double)(expected), "Double-precision value not less")
 #define TEST_EXPECT_DOUBLE_GREATER(actual, expected)       TEST_EXPECT((double)(actual) >  (double)(expected), "Double-precision value not greater")
 #define TEST_EXPECT_DOUBLE_GREATER_EQUAL(actual, expected) TEST_EXPECT((double)(actual) >= (double)(expected), "Double-precision value not greater or equal")
@@ -347,7 +357,7 @@ TEST_EXPECT(found, "Memory not contains assertion failed");
 #define TEST_EXPECT_DOUBLE_IS_NOT_DETERMINATE(actual)      TEST_EXPECT(std::isnan((double)actual)  || std::isinf((double)actual),    "Double-precision value deterministic")
 #else
 #define TEST_EXPECT_DOUBLE_EQUAL(actual, expected)         TEST_EXPECT(fabs((double)(actual) - (double)(expected)) <  XTEST_DOUBLE_EPSILON, "Double-precision value not equal within epsilon")
-#define TEST_EXPECT_DOUBLE_NOT_EQUAL(actual, expected)     TEST_EXPECT(fabs((double)(actual) - (double)(expected)) <= XTEST_DOUBLE_EPSILON, "Double-precision value equal within epsilon")
+#define TEST_EXPECT_DOUBLE_NOT_EQUAL(actual, expected)     TEST_EXPECT(fabs((double)(actual) - (double)(expected)) > XTEST_DOUBLE_EPSILON, "Double-precision value equal within epsilon")
 #define TEST_EXPECT_DOUBLE_LESS(actual, expected)          TEST_EXPECT((double)(actual) <  (double)(expected), "Double-precision value not less")
 #define TEST_EXPECT_DOUBLE_GREATER(actual, expected)       TEST_EXPECT((double)(actual) >  (double)(expected), "Double-precision value not greater")
 #define TEST_EXPECT_DOUBLE_GREATER_EQUAL(actual, expected) TEST_EXPECT((double)(actual) >= (double)(expected), "Double-precision value not greater or equal")
@@ -400,9 +410,9 @@ TEST_EXPECT(found, "Memory not contains assertion failed");
 #define TEST_EXPECT_CONTAINS_SUBSTRING_STRING(string, substring) TEST_EXPECT(strstr((string), (substring)) != nullptr, "Substring not found")
 #define TEST_EXPECT_NOT_CONTAINS_SUBSTRING_STRING(string, substring) TEST_EXPECT(strstr((string), (substring)) == nullptr, "Substring found")
 #define TEST_EXPECT_STARTS_WITH_STRING(string, prefix) TEST_EXPECT(strncmp((string), (prefix), strlen(prefix)) == 0, "String doesn't start with the prefix")
-#define TEST_EXPECT_ENDS_WITH_STRING(string, suffix) TEST_EXPECT(strstr((string), (suffix) != nullptr && (strlen(string) - strlen(suffix)) == (strstr(string, suffix) - string)), "String doesn't end with the suffix")
-#define TEST_EXPECT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
-#define TEST_EXPECT_NOT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
+#define TEST_EXPECT_ENDS_WITH_STRING(string, suffix) TEST_EXPECT((strstr(string, suffix) != nullptr && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix) == 0), "String doesn't end with the suffix")
+#define TEST_EXPECT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_EXPECT(xtest_strcasecmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
+#define TEST_EXPECT_NOT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_EXPECT(xtest_strcasecmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
 
 #define TEST_EXPECT_EQUAL_CSTRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) == 0, "String equality expectation not met")
 #define TEST_EXPECT_NOT_EQUAL_CSTRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) != 0, "String inequality expectation not met")
@@ -410,9 +420,9 @@ TEST_EXPECT(found, "Memory not contains assertion failed");
 #define TEST_EXPECT_CONTAINS_SUBSTRING_CSTRING(string, substring) TEST_EXPECT(strstr((string), (substring)) != NULL, "Substring not found")
 #define TEST_EXPECT_NOT_CONTAINS_SUBSTRING_CSTRING(string, substring) TEST_EXPECT(strstr((string), (substring)) == NULL, "Substring found")
 #define TEST_EXPECT_STARTS_WITH_CSTRING(string, prefix) TEST_EXPECT(strncmp((string), (prefix), strlen(prefix)) == 0, "String doesn't start with the prefix")
-#define TEST_EXPECT_ENDS_WITH_CSTRING(string, suffix) TEST_EXPECT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix)), "String doesn't end with the suffix")
-#define TEST_EXPECT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
-#define TEST_EXPECT_NOT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
+#define TEST_EXPECT_ENDS_WITH_CSTRING(string, suffix) TEST_EXPECT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix) == 0), "String doesn't end with the suffix")
+#define TEST_EXPECT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_EXPECT(xtest_strcasecmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
+#define TEST_EXPECT_NOT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_EXPECT(xtest_strcasecmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
 #else
 #define TEST_EXPECT_EQUAL_CSTRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) == 0, "String equality expectation not met")
 #define TEST_EXPECT_NOT_EQUAL_CSTRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) != 0, "String inequality expectation not met")
@@ -420,9 +430,9 @@ TEST_EXPECT(found, "Memory not contains assertion failed");
 #define TEST_EXPECT_CONTAINS_SUBSTRING_CSTRING(string, substring) TEST_EXPECT(strstr((string), (substring)) != NULL, "Substring not found")
 #define TEST_EXPECT_NOT_CONTAINS_SUBSTRING_CSTRING(string, substring) TEST_EXPECT(strstr((string), (substring)) == NULL, "Substring found")
 #define TEST_EXPECT_STARTS_WITH_CSTRING(string, prefix) TEST_EXPECT(strncmp((string), (prefix), strlen(prefix)) == 0, "String doesn't start with the prefix")
-#define TEST_EXPECT_ENDS_WITH_CSTRING(string, suffix) TEST_EXPECT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix)), "String doesn't end with the suffix")
-#define TEST_EXPECT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
-#define TEST_EXPECT_NOT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
+#define TEST_EXPECT_ENDS_WITH_CSTRING(string, suffix) TEST_EXPECT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix) == 0), "String doesn't end with the suffix")
+#define TEST_EXPECT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_EXPECT(xtest_strcasecmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
+#define TEST_EXPECT_NOT_EQUAL_CASE_INSENSITIVE_CSTRING(actual, expected) TEST_EXPECT(xtest_strcasecmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
 
 #define TEST_EXPECT_EQUAL_STRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) == 0, "String equality expectation not met")
 #define TEST_EXPECT_NOT_EQUAL_STRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) != 0, "String inequality expectation not met")
@@ -430,9 +440,9 @@ TEST_EXPECT(found, "Memory not contains assertion failed");
 #define TEST_EXPECT_CONTAINS_SUBSTRING_STRING(string, substring) TEST_EXPECT(strstr((string), (substring)) != NULL, "Substring not found")
 #define TEST_EXPECT_NOT_CONTAINS_SUBSTRING_STRING(string, substring) TEST_EXPECT(strstr((string), (substring)) == NULL, "Substring found")
 #define TEST_EXPECT_STARTS_WITH_STRING(string, prefix) TEST_EXPECT(strncmp((string), (prefix), strlen(prefix)) == 0, "String doesn't start with the prefix")
-#define TEST_EXPECT_ENDS_WITH_STRING(string, suffix) TEST_EXPECT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix)), "String doesn't end with the suffix")
-#define TEST_EXPECT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
-#define TEST_EXPECT_NOT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_EXPECT(strcmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
+#define TEST_EXPECT_ENDS_WITH_STRING(string, suffix) TEST_EXPECT((strstr(string, suffix) != NULL && strlen(string) >= strlen(suffix) && strcmp(string + strlen(string) - strlen(suffix), suffix) == 0), "String doesn't end with the suffix")
+#define TEST_EXPECT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_EXPECT(xtest_strcasecmp((actual), (expected)) == 0, "Case-insensitive string equality expectation not met")
+#define TEST_EXPECT_NOT_EQUAL_CASE_INSENSITIVE_STRING(actual, expected) TEST_EXPECT(xtest_strcasecmp((actual), (expected)) != 0, "Case-insensitive string inequality expectation not met")
 #endif
 
 // ----------------------------------------------------------------
@@ -29,6 +29,9 @@ extern "C"
 #if defined(_WIN32)
 #include <Windows.h>
 #endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #else
 #include <stdbool.h>
 #include <stdlib.h>
@@ -38,6 +41,9 @@ extern "C"
 #if defined(_WIN32)
 #include <Windows.h>
 #endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #endif
 
 // Used in floating point asserts
@@ -45,15 +51,20 @@ extern "C"
 #define XTEST_DOUBLE_EPSILON 1e-9
 
 typedef struct {
-    clock_t elapsed;     // Elapsed time for all tests
-    clock_t start;       // Elapsed time for start of tests
-    clock_t end;         // Elapsed time for end of tests
+    uint64_t elapsed;    // Wall time between start and end in nanoseconds
+    uint64_t start;      // Monotonic clock at the start in nanoseconds
+    uint64_t end;        // Monotonic clock at the end in nanoseconds
+    uint64_t user;       // User CPU time spent in nanoseconds
+    uint64_t system;     // System CPU time spent in nanoseconds
+    uint64_t cycles;     // Time-stamp counter cycles, zero where unsupported
 } xtime;
 
 typedef struct {
     bool ignored;             // Indicates if the test case is ignored
     bool is_mark;             // Flag to identify benchmark tests
     bool is_fish;             // Flag to identify Fish AI tests
+    uint64_t range_min;       // First input size of a benchmark sweep
+    uint64_t range_max;       // Last input size of a sweep, zero when not a sweep
 } xconfig;
 
 typedef struct {
@@ -70,19 +81,92 @@ typedef struct {
 } xtest;
 
 typedef struct {
-    uint16_t passed_count;     // Number of passed tests
-    uint16_t failed_count;     // Number of failed tests
-    uint16_t ignored_count;    // Number of ignored tests
-    uint16_t error_count;      // Number of error tests
-    uint16_t mark_count;      // Number of benchmarks tests
-    uint16_t fish_count;      // Number of fish AI tests
-    uint16_t test_count;      // Number of fish AI tests
-    uint16_t total_count;      // Total number of tests
+    uint64_t passed_count;     // Number of passed tests
+    uint64_t failed_count;     // Number of failed tests
+    uint64_t ignored_count;    // Number of ignored tests
+    uint64_t error_count;      // Number of error tests
+    uint64_t mark_count;       // Number of benchmarks tests
+    uint64_t fish_count;       // Number of fish AI tests
+    uint64_t test_count;       // Number of plain test cases
+    uint64_t total_count;      // Total number of tests
+    uint64_t iteration_count;  // Bodies run across all cases, above total_count when repeating
 } xstats;
 
+// Hardware counters per call of a benchmark, negative where unavailable
+typedef struct {
+    double cycles;        // Core cycles spent in user space
+    double instructions;  // Instructions retired
+    double l1d_misses;    // L1 data cache read misses
+    double llc_misses;    // Last level cache misses
+    double branch_misses; // Mispredicted branches
+} xmark_counters;
+
+// Summary of a benchmark sampled by --bench, all times in nanoseconds per call
+typedef struct {
+    uint64_t samples;     // Number of samples collected
+    uint64_t iterations;  // Calls of the body folded into each sample
+    double mean;          // Mean of the samples
+    double median;        // Median of the samples
+    double stddev;        // Sample standard deviation
+    double min;           // Fastest sample
+    double max;           // Slowest sample
+    double p99;           // 99th percentile of the samples
+    double ci_low;        // Lower bound of the 95% bootstrap interval of the median
+    double ci_high;       // Upper bound of the 95% bootstrap interval of the median
+    xmark_counters counters; // Collected with --perf while sampling
+    double bytes;         // Bytes processed per call, from XMARK_SET_BYTES
+    double items;         // Items processed per call, from XMARK_SET_ITEMS
+    double *values;       // Sorted samples, owned by the case table
+} xmark_stats;
+
+// Handle for one timed region, returned by start and consumed by stop
+typedef struct {
+    uint64_t start;       // Monotonic timestamp in nanoseconds
+    const char *label;    // Section name, NULL for an anonymous region
+    uint32_t depth;       // Number of regions already open on this thread
+} xmark_timer;
+
+// Flag bits packed per case in the engine case table
+#define XTEST_FLAG_MARK    0x01  // Benchmark case
+#define XTEST_FLAG_FISH    0x02  // Fish AI case
+#define XTEST_FLAG_IGNORED 0x04  // Case skipped itself during the run
+#define XTEST_FLAG_FAILED  0x08  // Case was scored as a failure
+#define XTEST_FLAG_ERRORED 0x10  // Case reported an error or crashed its worker
+
+// Cases queued by one XTEST_IMPORT_POOL call and the fixture they share
+typedef struct {
+    const char *name;          // Name of the pool function
+    xfixture *fixture;         // Set up before the first case, torn down after the last
+    volatile int64_t pending;  // Selected cases of the pool still to finish
+    volatile int64_t state;    // Progress of the fixture: idle, setting up, ready, done
+} xpool;
+
+#define XTEST_NO_POOL UINT32_MAX  // Pool index of cases queued outside any pool
+
+// Structure-of-arrays case table: hot columns first, cold metadata last
+typedef struct {
+    void (**functions)(void);  // Case entry points
+    xfixture **fixtures;       // Fixture wrapped around each case, or NULL
+    uint8_t *flags;            // XTEST_FLAG_* bits per case
+    uint64_t *durations;       // Last measured duration per case in nanoseconds
+    xtest **cases;             // Source structs, used for names and timers
+    xmark_stats *marks;        // Benchmark statistics, allocated only under --bench
+    uint32_t *groups;          // Pool each case was queued from, or XTEST_NO_POOL
+    xpool *pools;              // Pools in import order
+    size_t pool_count;         // Number of entries in pools
+    size_t pool_capacity;      // Allocated entries in pools
+    uint32_t current;          // Pool receiving cases, XTEST_NO_POOL between imports
+    size_t *order;             // Indices of the cases selected to run
+    size_t selected;           // Number of entries in order
+    size_t count;              // Number of collected cases
+    size_t capacity;           // Allocated slots per column
+} xtable;
+
 typedef struct {
     xstats stats;  // Test statistics including passed, failed, and ignored counts
     xtime timer;   // Xtest timer for tracking time
+    xtable table;  // Cases waiting to be dispatched at erase time
+    xfixture *global; // Fixture wrapped once around the whole run, or NULL
 } xengine;
 
 // =================================================================
@@ -94,10 +178,19 @@ xengine xtest_create(int argc, char **argv);
 int xtest_erase(xengine *runner);
 void xtest_run_as_test(xengine* engine, xtest* test_case);
 void xtest_run_as_fixture(xengine* engine, xtest* test_case, xfixture* fixture);
+void xtest_run_registered(xengine* engine);
+void xtest_import_pool(xengine* engine, const char *name, void (*pool)(xengine *runner));
+void xtest_pool_fixture(xengine* engine, xfixture* fixture);
+void xtest_global_fixture(xengine* engine, xfixture* fixture);
 
 // Function prototypes for Xmark
 void xmark_start_benchmark(void);
 uint64_t xmark_stop_benchmark(void);
+xmark_timer xmark_timer_start(const char *label);
+uint64_t xmark_timer_stop(xmark_timer *timer);
+void xmark_set_bytes(uint64_t bytes);
+void xmark_set_items(uint64_t items);
+uint64_t xmark_range_size(void);
 void xmark_assert_seconds(uint64_t elapsed_time_ns, double max_seconds);
 void xmark_assert_minutes(uint64_t elapsed_time_ns, double max_minutes);
 void xmark_expect_seconds(uint64_t elapsed_time_ns, double max_seconds);
@@ -108,6 +201,8 @@ void xerrors(const char* reason, const char* file, int line, const char* func);
 void xignore(const char* reason, const char* file, int line, const char* func);
 void xassert(bool expression, const char *message, const char* file, int line, const char* func);
 void xexpect(bool expression, const char *message, const char* file, int line, const char* func);
+void xtest_failure_begin(void);
+bool xtest_failure_end(void);
 
 // =================================================================
 // XTest create and erase commands
@@ -115,6 +210,23 @@ void xexpect(bool expression, const char *message, const char* file, int line, c
 #define XTEST_CREATE(argc, argv) xengine runner = xtest_create(argc, argv)
 #define XTEST_ERASE() xtest_erase(&runner)
 
+// =================================================================
+// Static registration: every case lands in one linker section
+// =================================================================
+#if defined(_MSC_VER)
+#pragma section("xtest$a", read, write)
+#pragma section("xtest$m", read, write)
+#pragma section("xtest$z", read, write)
+#define XTEST_REGISTER(test_case) \
+    __declspec(allocate("xtest$m")) xtest *test_case##_xtest_entry = &test_case
+#elif defined(__APPLE__)
+#define XTEST_REGISTER(test_case) \
+    __attribute__((used, section("__DATA,xtest_cases"))) xtest *test_case##_xtest_entry = &test_case
+#else
+#define XTEST_REGISTER(test_case) \
+    __attribute__((used, section("xtest_cases"))) xtest *test_case##_xtest_entry = &test_case
+#endif
+
 // =================================================================
 // XTest run commands
 // =================================================================
@@ -123,17 +235,20 @@ void xexpect(bool expression, const char *message, const char* file, int line, c
 
 #define XTEST_CASE_FIXTURE(fixture_name, test_case) \
     void test_case##_xtest_##fixture_name(void); \
-    xtest test_case = { #test_case, test_case##_xtest_##fixture_name, {NULL, NULL}, {false, false, false}, {0, 0, 0}}; \
+    xtest test_case = { #test_case, test_case##_xtest_##fixture_name, {setup_##fixture_name, teardown_##fixture_name}, {false, false, false}, {0, 0, 0, 0, 0, 0}}; \
+    XTEST_REGISTER(test_case); \
     void test_case##_xtest_##fixture_name(void)
 
 #define XTEST_MARK_FIXTURE(fixture_name, test_case) \
     void test_case##_xtest_##fixture_name(void); \
-    xtest test_case = { #test_case, test_case##_xtest_##fixture_name, {NULL, NULL}, {false, true, false}, {0, 0, 0}}; \
+    xtest test_case = { #test_case, test_case##_xtest_##fixture_name, {setup_##fixture_name, teardown_##fixture_name}, {false, true, false}, {0, 0, 0, 0, 0, 0}}; \
+    XTEST_REGISTER(test_case); \
     void test_case##_xtest_##fixture_name(void)
 
 #define XTEST_FISH_FIXTURE(fixture_name, test_case) \
     void test_case##_xtest_##fixture_name(void); \
-    xtest test_case = { #test_case, test_case##_xtest_##fixture_name, {NULL, NULL}, {false, false, true}, {0, 0, 0}}; \
+    xtest test_case = { #test_case, test_case##_xtest_##fixture_name, {setup_##fixture_name, teardown_##fixture_name}, {false, false, true}, {0, 0, 0, 0, 0, 0}}; \
+    XTEST_REGISTER(test_case); \
     void test_case##_xtest_##fixture_name(void)
 
 #define XTEST_FIXTURE(fixture_name) \
@@ -149,24 +264,44 @@ void xexpect(bool expression, const char *message, const char* file, int line, c
 // =================================================================
 #define XTEST_DEFINE_POOL(group_name) void group_name(xengine *runner)
 #define XTEST_EXTERN_POOL(group_name) extern void group_name(xengine *runner)
-#define XTEST_IMPORT_POOL(group_name) group_name(&runner)
+#define XTEST_IMPORT_POOL(group_name) xtest_import_pool(&runner, #group_name, group_name)
+
+// Fixtures set up once per pool (call inside XTEST_DEFINE_POOL) or once per
+// run (call in main before XTEST_ERASE), instead of around every case
+#define XTEST_POOL_FIXTURE(fixture) xtest_pool_fixture(runner, &fixture)
+#define XTEST_GLOBAL_FIXTURE(fixture) xtest_global_fixture(&runner, &fixture)
+
+// Queues every case found in the registration section; use instead of
+// importing pools, not alongside them, or cases will run twice
+#define XTEST_IMPORT_ALL() xtest_run_registered(&runner)
 
 // =================================================================
 // Implement test commands
 // =================================================================
 #define XTEST_CASE(name) \
     void name##_xtest(void); \
-    xtest name = { #name, name##_xtest, {NULL, NULL}, {false, false, false}, {0, 0, 0}}; \
+    xtest name = { #name, name##_xtest, {NULL, NULL}, {false, false, false}, {0, 0, 0, 0, 0, 0}}; \
+    XTEST_REGISTER(name); \
     void name##_xtest(void)
 
 #define XTEST_MARK(name) \
     void name##_xtest(void); \
-    xtest name = { #name, name##_xtest, {NULL, NULL}, {false, true, false}, {0, 0, 0}}; \
+    xtest name = { #name, name##_xtest, {NULL, NULL}, {false, true, false}, {0, 0, 0, 0, 0, 0}}; \
+    XTEST_REGISTER(name); \
+    void name##_xtest(void)
+
+// Benchmark run once per power of two from min_size to max_size; the body
+// reads the current size with XMARK_RANGE_SIZE()
+#define XTEST_MARK_RANGE(name, min_size, max_size) \
+    void name##_xtest(void); \
+    xtest name = { #name, name##_xtest, {NULL, NULL}, {false, true, false, min_size, max_size}, {0, 0, 0, 0, 0, 0}}; \
+    XTEST_REGISTER(name); \
     void name##_xtest(void)
 
 #define XTEST_FISH(name) \
     void name##_xtest(void); \
-    xtest name = { #name, name##_xtest, {NULL, NULL}, {false, false, true}, {0, 0, 0}}; \
+    xtest name = { #name, name##_xtest, {NULL, NULL}, {false, false, true}, {0, 0, 0, 0, 0, 0}}; \
+    XTEST_REGISTER(name); \
     void name##_xtest(void)
 
 // =================================================================
@@ -193,6 +328,48 @@ void xexpect(bool expression, const char *message, const char* file, int line, c
 
 #define XMARK_START_BENCHMARK() xmark_start_benchmark()
 #define XMARK_STOP_BENCHMARK() xmark_stop_benchmark()
+#define XMARK_TIMER_START(label) xmark_timer_start(label)
+#define XMARK_TIMER_STOP(timer) xmark_timer_stop(&(timer))
+#define XMARK_SET_BYTES(bytes) xmark_set_bytes(bytes)
+#define XMARK_SET_ITEMS(items) xmark_set_items(items)
+#define XMARK_RANGE_SIZE() xmark_range_size()
+
+// =================================================================
+// XMark optimizer barriers
+// =================================================================
+
+// Compiler-only barriers that emit no instructions: XMARK_ESCAPE makes the
+// memory behind a pointer observable, XMARK_DO_NOT_OPTIMIZE keeps an lvalue
+// and the work that produced it alive, and XMARK_CLOBBER_MEMORY forces
+// pending writes to be treated as read so stores are not elided.
+extern void *volatile xmark_sink;
+
+#if defined(__GNUC__) || defined(__clang__)
+static inline void xmark_escape(void *pointer) {
+    __asm__ __volatile__("" : : "r"(pointer) : "memory");
+}
+
+static inline void xmark_clobber_memory(void) {
+    __asm__ __volatile__("" : : : "memory");
+}
+#else
+// Fallback for compilers without GNU inline assembly: a store through a
+// volatile pointer that the optimizer cannot prove is dead
+static inline void xmark_escape(void *pointer) {
+    xmark_sink = pointer;
+}
+
+static inline void xmark_clobber_memory(void) {
+    xmark_sink = (void*)&xmark_sink;
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+#endif
+}
+#endif
+
+#define XMARK_ESCAPE(pointer) xmark_escape((void*)(pointer))
+#define XMARK_DO_NOT_OPTIMIZE(value) xmark_escape((void*)&(value))
+#define XMARK_CLOBBER_MEMORY() xmark_clobber_memory()
 #define XMARK_ASSERT_SECONDS(elapsed_time_ns, max_seconds) xmark_assert_seconds(elapsed_time_ns, max_seconds)
 #define XMARK_ASSERT_MINUTES(elapsed_time_ns, max_minutes) xmark_assert_minutes(elapsed_time_ns, max_minutes)
 #define XMARK_EXPECT_SECONDS(elapsed_time_ns, max_seconds) xmark_expect_seconds(elapsed_time_ns, max_seconds)
@@ -217,6 +394,20 @@ void xexpect(bool expression, const char *message, const char* file, int line, c
 #define TEST_IGNORE(reason) xignore(reason, __FILE__, __LINE__, __func__)
 #define TEST_XERROR(reason) xerrors(reason, __FILE__, __LINE__, __func__)
 
+// Compares two strings with ASCII letters folded to lower case, for the
+// case-insensitive string checks of xassert.h and xexpect.h.
+static inline int xtest_strcasecmp(const char *left, const char *right) {
+    for (;; left++, right++) {
+        int a = (unsigned char)*left;
+        int b = (unsigned char)*right;
+        a += (a >= 'A' && a <= 'Z')? 'a' - 'A' : 0;
+        b += (b >= 'A' && b <= 'Z')? 'a' - 'A' : 0;
+        if (a != b || a == '\0') {
+            return a - b;
+        }
+    }
+}
+
 // =================================================================
 // XTest utility commands
 // =================================================================
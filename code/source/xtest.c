@@ -13,6 +13,34 @@ Description:
 #include "fossil/xtest.h"
 #include <stdarg.h>
 #include <string.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define XTEST_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define XTEST_HAS_TSC 1
+#endif
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/resource.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sched.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#define XTEST_HAS_PERF 1
+#endif
 
 typedef struct {
     bool cutback;
@@ -22,196 +50,735 @@ typedef struct {
     bool only_fish;
     bool only_mark;
     bool repeat;
-    uint8_t iter_repeat;
+    uint64_t iter_repeat;     // Iterations of each case, or a cap for the modes below
+    uint64_t repeat_for_ns;   // Repeat each case until this much time passed, zero when off
+    bool until_failure;       // Repeat each case until an iteration fails
+    uint32_t jobs;
+    bool isolate;
+    bool color;
+    bool bench;
+    uint32_t bench_samples;
+    uint64_t bench_sample_ns;
+    uint64_t bench_warmup_ns;
+    const char *save_baseline;
+    const char *compare_baseline;
+    double tolerance;
+    bool perf;
+    int32_t pin_cpu;      // Core benchmarks are sampled on, -1 to let the scheduler pick
+    bool priority;
+    uint32_t shard_index;
+    uint32_t shard_count;
+    const char *report;   // File the results of this run are written to
+    const char **merge;   // Report files to combine instead of running cases
+    uint32_t merge_count;
+    const char *timings;  // Timing database read before and rewritten after the run
 } xparser;
 
 // Global xparser variable
 xparser xcli;
 
-// Static control panel for assert/expect and marks
-static uint8_t XEXPECT_PASS_SCAN = true;
-static uint8_t XASSERT_PASS_SCAN = true;
-static uint8_t XIGNORE_TEST_CASE = false;
-static uint8_t XERRORS_TEST_CASE = false;
-static uint8_t MAX_REPEATS = 100;
-static uint8_t MIN_REPEATS = 1;
+// Target of the portable XMARK_ESCAPE fallback declared in xtest.h, defined
+// for every compiler so a library and tests built by different ones still link
+void *volatile xmark_sink = NULL;
+
+// Thread-local storage so each worker keeps its own assert state
+#if defined(_MSC_VER)
+#define XTEST_THREAD_LOCAL __declspec(thread)
+#else
+#define XTEST_THREAD_LOCAL _Thread_local
+#endif
+
+// An XMARK threshold check held back until the benchmark samples are in
+typedef struct {
+    void (*check)(uint64_t elapsed_time_ns, double limit);
+    double limit;
+} xmark_check;
+
+#define XMARK_MAX_CHECKS 8
+
+// Time accumulated by a labelled timer region within the running case
+typedef struct {
+    const char *label;
+    uint32_t depth;       // Nesting level of the first region with this label
+    uint64_t calls;
+    uint64_t ns;
+} xmark_section;
+
+#define XMARK_MAX_SECTIONS 16
+#define XMARK_MAX_DEPTH 16
+
+// Spells out the value of a numeric macro inside a string literal
+#define XTEST_TEXT_VALUE(value) #value
+#define XTEST_TEXT(value) XTEST_TEXT_VALUE(value)
+#define XMARK_MAX_SIZES 64
+
+// Walks the powers of two of an XTEST_MARK_RANGE sweep without overflowing
+#define XMARK_RANGE_EACH(size, config) \
+    for (uint64_t size = ((config).range_min > 0)? (config).range_min : 1; \
+         size != 0 && size <= (config).range_max; \
+         size = (size <= (config).range_max / 2)? size * 2 : 0)
+
+// Per-case control panel for assert/expect and marks
+typedef struct {
+    bool assert_pass;     // No assertion has failed in the running case
+    bool expect_pass;     // No expectation has failed in the running case
+    bool ignored;         // The running case asked to be skipped
+    bool errored;         // The running case reported an error
+    bool checking;        // A check meant to fail is running muted
+    bool held_assert;     // assert_pass set aside while checking
+    bool held_expect;     // expect_pass set aside while checking
+    bool hushed;          // Console output is muted in the later rounds of a repeated run
+    bool quiet;           // Console output is muted while a benchmark is sampled
+    bool sampling;        // XMARK threshold checks are deferred to the statistics
+    bool region_used;     // The body timed itself with XMARK_START/STOP
+    uint64_t region_ns;   // Time spent inside outermost regions since the last reset
+    uint32_t depth;       // Timer regions currently open
+    xmark_timer open[XMARK_MAX_DEPTH]; // Regions opened by XMARK_START_BENCHMARK
+    uint32_t open_count;
+    uint32_t open_refused; // Starts past XMARK_MAX_DEPTH still waiting for their stop
+    xmark_section sections[XMARK_MAX_SECTIONS];
+    size_t section_count;
+    uint64_t bytes;       // Bytes one call of the body processes, zero if undeclared
+    uint64_t items;       // Items one call of the body processes, zero if undeclared
+    uint64_t range_size;  // Input size of the running sweep step, zero outside sweeps
+    xmark_check checks[XMARK_MAX_CHECKS];
+    size_t check_count;   // Deferred checks recorded in checks
+    const char *failure;  // First assert/expect message muted while sampling
+    const char *failure_file;
+    const char *failure_func;
+    int failure_line;
+    bool failure_expect;  // The muted failure came from an expectation
+    uint64_t iteration;   // Zero-based iteration of a repeated case; later ones stay quiet
+    uint64_t failed_at;   // One-based iteration that first failed, zero if none did
+    uint64_t spent_ns;    // Time in the bodies over every iteration
+    uint64_t fastest_ns;
+    uint64_t slowest_ns;
+} xcontext;
+
+// Context of the case running on this thread, reset before every case
+static XTEST_THREAD_LOCAL xcontext xctx = {.assert_pass = true, .expect_pass = true};
+
+// Round of a --repeat-for or --until-failure run, changed only between rounds
+static uint64_t xround = 0;
+
+// Option limits, enumerators so the option table can name them
+enum {
+    MIN_REPEATS = 1,
+    MAX_JOBS = 1024,
+    MAX_SHARDS = 65536,
+    MAX_SAMPLES = 10000
+};
+// Most calls of a benchmark body folded into one calibrated sample
+static const uint64_t MAX_ITERATIONS = 1ULL << 32;
 
 //
 // local types
 //
 typedef char *xstring;
-static uint64_t start_time;
-#if defined(_WIN32)
-static double frequency; // Variable to store the frequency for Windows
-#endif
 
 // =================================================================
 // XEngine utility functions
 // =================================================================
-static uint16_t xengine_get_passed_count(xengine *runner) {
+static uint64_t xengine_get_passed_count(xengine *runner) {
     return runner->stats.passed_count;
 }
 
-static uint16_t xengine_get_failed_count(xengine *runner) {
+static uint64_t xengine_get_failed_count(xengine *runner) {
     return runner->stats.failed_count;
 }
 
-static uint16_t xengine_get_skipped_count(xengine *runner) {
+static uint64_t xengine_get_skipped_count(xengine *runner) {
     return runner->stats.ignored_count;
 }
 
-static uint16_t xengine_get_errors_count(xengine *runner) {
+static uint64_t xengine_get_errors_count(xengine *runner) {
     return runner->stats.error_count;
 }
 
-static uint16_t xengine_get_mark_count(xengine *runner) {
+static uint64_t xengine_get_mark_count(xengine *runner) {
     return runner->stats.mark_count;
 }
 
-static uint16_t xengine_get_fish_count(xengine *runner) {
+static uint64_t xengine_get_fish_count(xengine *runner) {
     return runner->stats.fish_count;
 }
 
-static uint16_t xengine_get_test_count(xengine *runner) {
+static uint64_t xengine_get_test_count(xengine *runner) {
     return runner->stats.test_count;
 }
 
-static uint16_t xengine_get_total_count(xengine *runner) {
+static uint64_t xengine_get_total_count(xengine *runner) {
     return runner->stats.total_count;
 }
 
+// ==============================================================================
+// Xtest internal timing
+// ==============================================================================
+
+#if defined(_WIN32)
+// Performance counter ticks per second, fixed at boot and read once by
+// xtime_init before any worker starts, so the workers only ever read it
+static uint64_t xtime_freq = 1;
+#endif
+
+static void xtime_init(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER query;
+    QueryPerformanceFrequency(&query);
+    xtime_freq = (uint64_t)query.QuadPart;
+#endif
+} // end of func
+
+// Monotonic wall clock in nanoseconds.
+static uint64_t xtime_now(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    // Split into whole seconds and remainder so neither product overflows or rounds
+    uint64_t ticks = (uint64_t)counter.QuadPart;
+    return ticks / xtime_freq * 1000000000ULL + ticks % xtime_freq * 1000000000ULL / xtime_freq;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+} // end of func
+
+// CPU time of the calling thread where the platform can tell, else of the process.
+static void xtime_cpu(uint64_t *user, uint64_t *system) {
+#if defined(_WIN32)
+    FILETIME created, exited, kernel, usermode;
+    GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &usermode);
+    *user = ((((uint64_t)usermode.dwHighDateTime) << 32) | usermode.dwLowDateTime) * 100;
+    *system = ((((uint64_t)kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) * 100;
+#else
+    struct rusage usage;
+#if defined(RUSAGE_THREAD)
+    getrusage(RUSAGE_THREAD, &usage);
+#else
+    getrusage(RUSAGE_SELF, &usage);
+#endif
+    *user = (uint64_t)usage.ru_utime.tv_sec * 1000000000ULL + (uint64_t)usage.ru_utime.tv_usec * 1000ULL;
+    *system = (uint64_t)usage.ru_stime.tv_sec * 1000000000ULL + (uint64_t)usage.ru_stime.tv_usec * 1000ULL;
+#endif
+} // end of func
+
+static uint64_t xtime_cycles(void) {
+#if defined(XTEST_HAS_TSC)
+    return (uint64_t)__rdtsc();
+#else
+    return 0;
+#endif
+} // end of func
+
+// Starts a timer; the CPU readings are kept as baselines until xtime_stop.
+static void xtime_start(xtime *timer) {
+    xtime_cpu(&timer->user, &timer->system);
+    timer->cycles = xtime_cycles();
+    timer->start = xtime_now();
+} // end of func
+
+static void xtime_stop(xtime *timer) {
+    uint64_t user = 0;
+    uint64_t system = 0;
+    timer->end = xtime_now();
+    timer->cycles = xtime_cycles() - timer->cycles;
+    xtime_cpu(&user, &system);
+    timer->elapsed = timer->end - timer->start;
+    timer->user = user - timer->user;
+    timer->system = system - timer->system;
+} // end of func
+
 // ==============================================================================
 // Xtest internal console stream logic
 // ==============================================================================
 
+typedef enum {
+    XCOLOR_NONE,
+    XCOLOR_RESET,
+    XCOLOR_BLACK,
+    XCOLOR_GRAY,
+    XCOLOR_WHITE,
+    XCOLOR_RED,
+    XCOLOR_GREEN,
+    XCOLOR_YELLOW,
+    XCOLOR_BLUE,
+    XCOLOR_MAGENTA,
+    XCOLOR_CYAN
+} xcolor;
+
+#define XCOLOR_ESCAPE(code) { code, sizeof(code) - 1 }
+
+// Escape sequences indexed by xcolor
+static const struct {
+    const char *text;
+    size_t length;
+} XCOLOR_ESCAPES[] = {
+    XCOLOR_ESCAPE(""),
+    XCOLOR_ESCAPE("\033[0m"),
+    XCOLOR_ESCAPE("\033[0;30m"),
+    XCOLOR_ESCAPE("\033[1;30m"),
+    XCOLOR_ESCAPE("\033[1;37m"),
+    XCOLOR_ESCAPE("\033[0;31m"),
+    XCOLOR_ESCAPE("\033[0;32m"),
+    XCOLOR_ESCAPE("\033[0;33m"),
+    XCOLOR_ESCAPE("\033[0;34m"),
+    XCOLOR_ESCAPE("\033[0;35m"),
+    XCOLOR_ESCAPE("\033[0;36m")
+};
+
+// Per-thread output buffer, written out in large chunks instead of one
+// printf per fragment; every thread flushes its own after every case
+#define XTEST_OUTPUT_SIZE 65536
+
+typedef struct {
+    char *data;        // Allocated on first use by each thread
+    size_t used;       // Bytes waiting to be written
+    xstring name;      // Scratch space for display names
+    size_t name_size;  // Bytes allocated for name
+} xoutput;
+
+static XTEST_THREAD_LOCAL xoutput xout = {NULL, 0, NULL, 0};
+
+// Writes everything buffered by the calling thread in a single stdio call.
+static void xoutput_flush(void) {
+    if (xout.used > 0) {
+        fwrite(xout.data, 1, xout.used, stdout);
+        xout.used = 0;
+    }
+} // end of func
+
+// Flushes and frees the calling thread's buffer.
+static void xoutput_release(void) {
+    xoutput_flush();
+    fflush(stdout);
+    free(xout.data);
+    free(xout.name);
+    xout = (xoutput){NULL, 0, NULL, 0};
+} // end of func
+
+static bool xoutput_ready(void) {
+    if (xout.data == NULL) {
+        xout.data = (char*)malloc(XTEST_OUTPUT_SIZE);
+        xout.used = 0;
+    }
+    return xout.data != NULL;
+} // end of func
+
+static void xoutput_append(const char *text, size_t length) {
+    if (!xoutput_ready() || length > XTEST_OUTPUT_SIZE) {
+        xoutput_flush();
+        fwrite(text, 1, length, stdout);
+        return;
+    }
+    if (xout.used + length > XTEST_OUTPUT_SIZE) {
+        xoutput_flush();
+    }
+    memcpy(xout.data + xout.used, text, length);
+    xout.used += length;
+} // end of func
+
+static void xoutput_format(const char *format, va_list args) {
+    if (!xoutput_ready()) {
+        vprintf(format, args);
+        return;
+    }
+
+    va_list retry;
+    va_copy(retry, args);
+    size_t room = XTEST_OUTPUT_SIZE - xout.used;
+    int length = vsnprintf(xout.data + xout.used, room, format, args);
+
+    if (length >= 0 && (size_t)length < room) {
+        xout.used += (size_t)length;
+    } else if (length >= 0) {
+        // Did not fit: drain the buffer and format again from the start
+        xoutput_flush();
+        if ((size_t)length < XTEST_OUTPUT_SIZE) {
+            vsnprintf(xout.data, XTEST_OUTPUT_SIZE, format, retry);
+            xout.used = (size_t)length;
+        } else {
+            vprintf(format, retry);
+        }
+    }
+    va_end(retry);
+} // end of func
+
 // Error Output Function
 static void xtest_console_err(const char *format, ...) {
     va_list args;
     va_start(args, format);
+    xoutput_flush();
+    fflush(stdout);
     vfprintf(stderr, format, args);
     va_end(args);
 }
 
 // Color Output Function
-static void xtest_console_out(const char *color_name, const char *format, ...) {
+static void xtest_console_out(xcolor color, const char *format, ...) {
+    if (xctx.quiet || xctx.hushed) {
+        return;
+    }
+
     va_list args;
     va_start(args, format);
 
-    if (strcmp(color_name, "reset") == 0) {
-        printf("\033[0m");
-    } else if (strcmp(color_name, "black") == 0) {
-        printf("\033[0;30m");
-    } else if (strcmp(color_name, "gray") == 0) {
-        printf("\033[1;30m");
-    } else if (strcmp(color_name, "white") == 0) {
-        printf("\033[1;37m");
-    } else if (strcmp(color_name, "red") == 0) {
-        printf("\033[0;31m");
-    } else if (strcmp(color_name, "green") == 0) {
-        printf("\033[0;32m");
-    } else if (strcmp(color_name, "yellow") == 0) {
-        printf("\033[0;33m");
-    } else if (strcmp(color_name, "blue") == 0) {
-        printf("\033[0;34m");
-    } else if (strcmp(color_name, "magenta") == 0) {
-        printf("\033[0;35m");
-    } else if (strcmp(color_name, "cyan") == 0) {
-        printf("\033[0;36m");
-    } else {
-        // Default to classic output if an unsupported color is specified
-        vprintf(format, args);
+    if (!xcli.color || color == XCOLOR_NONE) {
+        xoutput_format(format, args);
         va_end(args);
         return;
     }
 
-    vprintf(format, args);
-    printf("\033[0m"); // Reset color
+    xoutput_append(XCOLOR_ESCAPES[color].text, XCOLOR_ESCAPES[color].length);
+    xoutput_format(format, args);
+    xoutput_append(XCOLOR_ESCAPES[XCOLOR_RESET].text, XCOLOR_ESCAPES[XCOLOR_RESET].length);
     va_end(args);
 }
 
-static xstring xtest_console_name(const char *input) {
+// Converts a case name for display into the thread's reusable scratch buffer,
+// which only grows when a longer name comes along.
+static const char *xtest_console_name(const char *input) {
     if (input == NULL) {
         // Handle NULL input gracefully
         xtest_console_err("Error: Input string is NULL\n");
-        return NULL;
+        return "";
     }
 
     // Get the length of the input string
     size_t length = strlen(input);
 
-    // Allocate memory for the new string (including space for null terminator)
-    char *result = (char*)malloc((length + 1) * sizeof(char));
-
-    if (result == NULL) {
-        // Memory allocation failed
-        xtest_console_err("Error: Memory allocation failed\n");
-        return NULL;
+    if (length + 1 > xout.name_size) {
+        xstring result = (xstring)realloc(xout.name, length + 1);
+        if (result == NULL) {
+            // Memory allocation failed, show the raw name instead
+            xtest_console_err("Error: Memory allocation failed\n");
+            return input;
+        }
+        xout.name = result;
+        xout.name_size = length + 1;
     }
 
     // Iterate through each character in the input string
     for (size_t i = 0; i < length; i++) {
         // Replace underscores with spaces
-        result[i] = (input[i] == '_') ? ' ' : input[i];
+        xout.name[i] = (input[i] == '_') ? ' ' : input[i];
     }
 
     // Add null terminator to the end of the new string
-    result[length] = '\0';
+    xout.name[length] = '\0';
 
-    return result;
+    return xout.name;
 }
 
 // Formats and displays information about the start/end of a test case.
-static void xtest_output_start(xtest *test_case, xengine* engine) {
+static void xtest_output_start(xtest *test_case, size_t index) {
     if (xcli.verbose && !xcli.cutback) {
-        xtest_console_out("blue", "[Running Test Case] ...\n");
-        xtest_console_out("cyan", "TITLE: - %s\n", xtest_console_name(test_case->name));
-        xtest_console_out("cyan", "INDEX: - %.2i\n", engine->stats.total_count + 1);
-        xtest_console_out("cyan", "CLASS: - %s\n", (test_case->config.is_fish)? "Fish AI" : (test_case->config.is_mark)? "Benchmark" : "Test Case");
+        xtest_console_out(XCOLOR_BLUE, "[Running Test Case] ...\n");
+        xtest_console_out(XCOLOR_CYAN, "TITLE: - %s\n", xtest_console_name(test_case->name));
+        xtest_console_out(XCOLOR_CYAN, "INDEX: - %02" PRIu64 "\n", (uint64_t)index + 1);
+        xtest_console_out(XCOLOR_CYAN, "CLASS: - %s\n", (test_case->config.is_fish)? "Fish AI" : (test_case->config.is_mark)? "Benchmark" : "Test Case");
     } else if (!xcli.cutback && !xcli.verbose) {
-        xtest_console_out("blue", "> name: - %s\n", xtest_console_name(test_case->name));
-        xtest_console_out("blue", "> type: - %s\n", (test_case->config.is_fish)? "fish" : (test_case->config.is_mark)? "mark" : "test");
+        xtest_console_out(XCOLOR_BLUE, "> name: - %s\n", xtest_console_name(test_case->name));
+        xtest_console_out(XCOLOR_BLUE, "> type: - %s\n", (test_case->config.is_fish)? "fish" : (test_case->config.is_mark)? "mark" : "test");
     }
 } // end of func
 
-static void xtest_output_end(xtest *test_case, xengine* engine) {
+static void xtest_output_end(xtest *test_case) {
     if (xcli.verbose && !xcli.cutback) {
-        int minutes = (int)(test_case->timer.elapsed / (60 * 1000));
-        int seconds = (int)((test_case->timer.elapsed - minutes * 60 * 1000) / 1000);
-        int millis = (int)(test_case->timer.elapsed - minutes * 60 * 1000 - seconds * 1000);
-        xtest_console_out("cyan", "TIME  : - %d minutes, %d seconds, and %d milliseconds\n", minutes, seconds, millis);
-        xtest_console_out("cyan", "SKIP  : - %s\n", test_case->config.ignored ? "yes" : "no");
-        xtest_console_out("blue", "[Current Case Done] ...\n");
+        uint64_t elapsed = test_case->timer.elapsed / 1000000;
+        int minutes = (int)(elapsed / (60 * 1000));
+        int seconds = (int)((elapsed - minutes * 60 * 1000) / 1000);
+        int millis = (int)(elapsed - minutes * 60 * 1000 - seconds * 1000);
+        xtest_console_out(XCOLOR_CYAN, "TIME  : - %d minutes, %d seconds, and %d milliseconds\n", minutes, seconds, millis);
+        xtest_console_out(XCOLOR_CYAN, "WALL  : - %" PRIu64 " ns\n", test_case->timer.elapsed);
+        xtest_console_out(XCOLOR_CYAN, "CPU   : - %.3f ms user, %.3f ms system\n", test_case->timer.user / 1e6, test_case->timer.system / 1e6);
+        if (test_case->timer.cycles) {
+            xtest_console_out(XCOLOR_CYAN, "CYCLES: - %" PRIu64 "\n", test_case->timer.cycles);
+        }
+        xtest_console_out(XCOLOR_CYAN, "SKIP  : - %s\n", test_case->config.ignored ? "yes" : "no");
+        if (xctx.iteration > 1) {
+            xtest_console_out(XCOLOR_CYAN, "REPEAT: - %" PRIu64 " iterations, %" PRIu64 "/%" PRIu64 "/%" PRIu64 " ns min/mean/max\n",
+                              xctx.iteration, xctx.fastest_ns, xctx.spent_ns / xctx.iteration, xctx.slowest_ns);
+        }
+        if (xctx.iteration > 1 && xctx.failed_at > 0) {
+            xtest_console_out(XCOLOR_RED, "FIRST : - failed on iteration %" PRIu64 "\n", xctx.failed_at);
+        }
+        for (size_t i = 0; i < xctx.section_count; i++) {
+            const xmark_section *section = &xctx.sections[i];
+            if (section->calls == 0) {
+                continue;
+            }
+            xtest_console_out(XCOLOR_CYAN, "SECTN : - %*s%s: %" PRIu64 " ns/call over %" PRIu64 " calls\n",
+                              (int)(section->depth * 2), "", section->label, section->ns / section->calls, section->calls);
+        }
+        xtest_console_out(XCOLOR_BLUE, "[Current Case Done] ...\n");
     } else if (!xcli.cutback && !xcli.verbose) {
-        xtest_console_out("blue", "ignore: %s\n", test_case->config.ignored ? "yes" : "no");
+        xtest_console_out(XCOLOR_BLUE, "ignore: %s\n", test_case->config.ignored ? "yes" : "no");
+        if (xctx.iteration > 1 && xctx.failed_at > 0) {
+            xtest_console_out(XCOLOR_RED, "repeat: failed on iteration %" PRIu64 " of %" PRIu64 "\n", xctx.failed_at, xctx.iteration);
+        }
     }
 } // end of func
 
 // Output for XUnit Test Case Report.
 static void xtest_output_report(xengine *runner) {
-    runner->timer.end = clock();
-    // Calculate elapsed time and store it in the test case
-    runner->timer.elapsed = ((double)(runner->timer.end - runner->timer.start)  / CLOCKS_PER_SEC) * 1000.0;
-    int minutes = (int)(runner->timer.elapsed / (60 * 1000));
-    int seconds = (int)((runner->timer.elapsed - minutes * 60 * 1000) / 1000);
-    int millis = (int)(runner->timer.elapsed - minutes * 60 * 1000 - seconds * 1000);
-
-    xtest_console_out("blue", "[ ===== Xtest report system ===== ] %d minutes, %d seconds, and %d milliseconds\n", minutes, seconds, millis);
-    xtest_console_out("white",     "===================================\n");
+    uint64_t elapsed = runner->timer.elapsed / 1000000;
+    int minutes = (int)(elapsed / (60 * 1000));
+    int seconds = (int)((elapsed - minutes * 60 * 1000) / 1000);
+    int millis = (int)(elapsed - minutes * 60 * 1000 - seconds * 1000);
+
+    xtest_console_out(XCOLOR_BLUE, "[ ===== Xtest report system ===== ] %d minutes, %d seconds, and %d milliseconds\n", minutes, seconds, millis);
+    xtest_console_out(XCOLOR_WHITE,    "===================================\n");
     if (xcli.verbose && !xcli.cutback) {
-        xtest_console_out("magenta", "PASSED    : - %.2i\n",     xengine_get_passed_count(runner));
-        xtest_console_out("magenta", "FAILED    : - %.2i\n",     xengine_get_failed_count(runner));
-        xtest_console_out("magenta", "SKIPPED   : - %.2i\n",     xengine_get_skipped_count(runner));
-        xtest_console_out("magenta", "ERRORS    : - %.2i\n",     xengine_get_errors_count(runner));
-        xtest_console_out("magenta", "TOTAL MARK: - %.2i\n",     xengine_get_mark_count(runner));
-        xtest_console_out("magenta", "TOTAL FISH: - %.2i\n",     xengine_get_fish_count(runner));
-        xtest_console_out("magenta", "TOTAL TEST: - %.2i\n",     xengine_get_test_count(runner));
-        xtest_console_out("yellow",  "ALL TEST CASES: - %.2i\n", xengine_get_total_count(runner));
+        xtest_console_out(XCOLOR_MAGENTA, "PASSED    : - %02" PRIu64 "\n",     xengine_get_passed_count(runner));
+        xtest_console_out(XCOLOR_MAGENTA, "FAILED    : - %02" PRIu64 "\n",     xengine_get_failed_count(runner));
+        xtest_console_out(XCOLOR_MAGENTA, "SKIPPED   : - %02" PRIu64 "\n",     xengine_get_skipped_count(runner));
+        xtest_console_out(XCOLOR_MAGENTA, "ERRORS    : - %02" PRIu64 "\n",     xengine_get_errors_count(runner));
+        xtest_console_out(XCOLOR_MAGENTA, "TOTAL MARK: - %02" PRIu64 "\n",     xengine_get_mark_count(runner));
+        xtest_console_out(XCOLOR_MAGENTA, "TOTAL FISH: - %02" PRIu64 "\n",     xengine_get_fish_count(runner));
+        xtest_console_out(XCOLOR_MAGENTA, "TOTAL TEST: - %02" PRIu64 "\n",     xengine_get_test_count(runner));
+        xtest_console_out(XCOLOR_YELLOW,   "ALL TEST CASES: - %02" PRIu64 "\n", xengine_get_total_count(runner));
+        if (runner->stats.iteration_count > runner->stats.total_count) {
+            xtest_console_out(XCOLOR_YELLOW, "ITERATIONS: - %02" PRIu64 "\n", runner->stats.iteration_count);
+        }
     } else if (!xcli.verbose && !xcli.cutback) {
-        xtest_console_out("magenta", "pass: %.2i, fail: %.2i\n", xengine_get_passed_count(runner), xengine_get_failed_count(runner));
+        xtest_console_out(XCOLOR_MAGENTA, "pass: %02" PRIu64 ", fail: %02" PRIu64 "\n", xengine_get_passed_count(runner), xengine_get_failed_count(runner));
+        if (runner->stats.iteration_count > runner->stats.total_count) {
+            xtest_console_out(XCOLOR_MAGENTA, "iterations: %02" PRIu64 "\n", runner->stats.iteration_count);
+        }
     } else if (!xcli.verbose && xcli.cutback) {
-        xtest_console_out("magenta", "result: %s\n", xengine_get_failed_count(runner)? "fail" : "pass");
+        xtest_console_out(XCOLOR_MAGENTA, "result: %s\n", xengine_get_failed_count(runner)? "fail" : "pass");
+    }
+    xtest_console_out(XCOLOR_WHITE,    "===================================\n\n");
+} // end of func
+
+// ==============================================================================
+// Xtest case filter
+// ==============================================================================
+
+// One --filter pattern, split at its first wildcard
+typedef struct {
+    char *text;
+    size_t prefix;        // Characters before the first '*' or '?'
+    bool hit;             // Matched a case or pool name during selection
+} xpattern;
+
+// Globs sharing one literal prefix, a range of the sorted glob patterns
+typedef struct {
+    const char *text;     // Prefix characters, not terminated
+    size_t length;
+    size_t first;         // Index of the first pattern of the range
+    size_t count;
+} xprefix;
+
+// Patterns of one polarity: plain names first, sorted for bsearch, then globs
+// sorted by literal prefix. Globs are only tried when their prefix heads the
+// name, found by one bsearch over the prefix table per distinct prefix length.
+typedef struct {
+    xpattern *patterns;
+    size_t count;
+    size_t capacity;
+    size_t plain;         // Leading patterns without wildcards
+    xprefix *prefixes;    // Sorted by length, then text
+    size_t prefix_count;
+    size_t *lengths;      // Distinct prefix lengths, ascending
+    size_t length_count;
+} xpatterns;
+
+// Patterns a case must match one of, then patterns it must match none of
+static xpatterns xfilter[2] = {{NULL, 0, 0, 0, NULL, 0, NULL, 0}, {NULL, 0, 0, 0, NULL, 0, NULL, 0}};
+
+// Matches the rest of a glob after its literal prefix. A '*' only ever
+// resumes from the latest star, so the walk stays linear for case names.
+static bool xglob_match(const char *pattern, const char *name) {
+    const char *star = NULL;
+    const char *resume = NULL;
+    while (*name != '\0') {
+        if (*pattern == '?' || (*pattern == *name && *pattern != '*')) {
+            pattern++;
+            name++;
+        } else if (*pattern == '*') {
+            star = pattern++;
+            resume = name;
+        } else if (star != NULL) {
+            pattern = star + 1;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+} // end of func
+
+// Adds a comma separated --filter list; a leading '-' excludes the pattern.
+static void xfilter_add(const char *list) {
+    while (*list != '\0') {
+        size_t length = strcspn(list, ",");
+        const char *piece = list;
+        list += length + (list[length] == ',');
+
+        bool exclude = (*piece == '-');
+        piece += exclude;
+        length -= exclude;
+        if (length == 0) {
+            continue;
+        }
+
+        xpatterns *patterns = &xfilter[exclude];
+        if (patterns->count == patterns->capacity) {
+            patterns->capacity = (patterns->capacity)? patterns->capacity * 2 : 8;
+            patterns->patterns = (xpattern*)realloc(patterns->patterns, patterns->capacity * sizeof(xpattern));
+        }
+        char *text = (char*)malloc(length + 1);
+        if (patterns->patterns == NULL || text == NULL) {
+            xtest_console_err("Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(text, piece, length);
+        text[length] = '\0';
+        patterns->patterns[patterns->count++] = (xpattern){text, strcspn(text, "*?"), false};
+    }
+} // end of func
+
+static int xpattern_compare(const void *left, const void *right) {
+    const xpattern *a = (const xpattern*)left;
+    const xpattern *b = (const xpattern*)right;
+    bool a_glob = a->text[a->prefix] != '\0';
+    bool b_glob = b->text[b->prefix] != '\0';
+    if (a_glob != b_glob) {
+        return a_glob - b_glob;
+    }
+    if (a_glob && a->prefix != b->prefix) {
+        return (a->prefix < b->prefix)? -1 : 1;
+    }
+    if (a_glob) {
+        int order = strncmp(a->text, b->text, a->prefix);
+        return (order != 0)? order : strcmp(a->text, b->text);
+    }
+    return strcmp(a->text, b->text);
+} // end of func
+
+static int xprefix_compare(const void *left, const void *right) {
+    const xprefix *a = (const xprefix*)left;
+    const xprefix *b = (const xprefix*)right;
+    if (a->length != b->length) {
+        return (a->length < b->length)? -1 : 1;
+    }
+    return strncmp(a->text, b->text, a->length);
+} // end of func
+
+// Sorts each list once after parsing so plain names are found by bsearch
+// and globs are grouped into the prefix table.
+static void xfilter_compile(void) {
+    for (size_t side = 0; side < 2; side++) {
+        xpatterns *patterns = &xfilter[side];
+        if (patterns->count > 1) {
+            qsort(patterns->patterns, patterns->count, sizeof(xpattern), xpattern_compare);
+        }
+        patterns->plain = 0;
+        while (patterns->plain < patterns->count &&
+               patterns->patterns[patterns->plain].text[patterns->patterns[patterns->plain].prefix] == '\0') {
+            patterns->plain++;
+        }
+
+        size_t globs = patterns->count - patterns->plain;
+        if (globs == 0) {
+            continue;
+        }
+        patterns->prefixes = (xprefix*)malloc(globs * sizeof(xprefix));
+        patterns->lengths = (size_t*)malloc(globs * sizeof(size_t));
+        if (patterns->prefixes == NULL || patterns->lengths == NULL) {
+            xtest_console_err("Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t index = patterns->plain; index < patterns->count; index++) {
+            const xpattern *pattern = &patterns->patterns[index];
+            xprefix group = {pattern->text, pattern->prefix, index, 1};
+            xprefix *last = (patterns->prefix_count)? &patterns->prefixes[patterns->prefix_count - 1] : NULL;
+            if (last != NULL && xprefix_compare(last, &group) == 0) {
+                last->count++;
+                continue;
+            }
+            patterns->prefixes[patterns->prefix_count++] = group;
+            if (last == NULL || last->length != group.length) {
+                patterns->lengths[patterns->length_count++] = group.length;
+            }
+        }
+    }
+} // end of func
+
+static bool xfilter_hit(xpatterns *patterns, const char *name) {
+    size_t length = strlen(name);
+    xpattern key = {(char*)name, length, false};
+    xpattern *plain = (xpattern*)bsearch(&key, patterns->patterns, patterns->plain, sizeof(xpattern), xpattern_compare);
+    if (plain != NULL) {
+        plain->hit = true;
+        return true;
+    }
+    for (size_t each = 0; each < patterns->length_count && patterns->lengths[each] <= length; each++) {
+        xprefix head = {name, patterns->lengths[each], 0, 0};
+        const xprefix *group = (const xprefix*)bsearch(&head, patterns->prefixes, patterns->prefix_count, sizeof(xprefix), xprefix_compare);
+        for (size_t index = 0; group != NULL && index < group->count; index++) {
+            xpattern *pattern = &patterns->patterns[group->first + index];
+            if (xglob_match(pattern->text + pattern->prefix, name + pattern->prefix)) {
+                pattern->hit = true;
+                return true;
+            }
+        }
+    }
+    return false;
+} // end of func
+
+// A case runs when its name or its pool's name matches an included pattern,
+// or nothing is included, and neither name matches an excluded one.
+static bool xfilter_accepts(const char *name, const char *pool) {
+    bool included = xfilter[0].count == 0 || xfilter_hit(&xfilter[0], name) ||
+                    (pool != NULL && xfilter_hit(&xfilter[0], pool));
+    return included && !xfilter_hit(&xfilter[1], name) &&
+           !(pool != NULL && xfilter_hit(&xfilter[1], pool));
+} // end of func
+
+// Whether one pattern matches a name, for the patterns selection never hit.
+static bool xfilter_matches(const xpattern *pattern, const char *name) {
+    return strncmp(name, pattern->text, pattern->prefix) == 0 &&
+           (pattern->text[pattern->prefix] != '\0' || name[pattern->prefix] == '\0') &&
+           xglob_match(pattern->text + pattern->prefix, name + pattern->prefix);
+} // end of func
+
+// Warns about patterns that match no registered case or pool, usually a typo.
+// Selection stops at the first pattern that matches, so only the patterns it
+// never reached are checked again against every name.
+static void xfilter_report_unused(const xtable *table) {
+    for (size_t side = 0; side < 2; side++) {
+        for (size_t index = 0; index < xfilter[side].count; index++) {
+            const xpattern *pattern = &xfilter[side].patterns[index];
+            bool used = pattern->hit;
+            for (size_t each = 0; !used && each < table->count; each++) {
+                uint32_t group = table->groups[each];
+                used = xfilter_matches(pattern, table->cases[each]->name) ||
+                       (group != XTEST_NO_POOL && xfilter_matches(pattern, table->pools[group].name));
+            }
+            if (!used) {
+                xtest_console_err("Warning: --filter pattern '%s%s' matches no case or pool\n", (side == 1)? "-" : "", pattern->text);
+            }
+        }
+    }
+} // end of func
+
+static void xfilter_erase(void) {
+    for (size_t side = 0; side < 2; side++) {
+        for (size_t index = 0; index < xfilter[side].count; index++) {
+            free(xfilter[side].patterns[index].text);
+        }
+        free(xfilter[side].patterns);
+        free(xfilter[side].prefixes);
+        free(xfilter[side].lengths);
+        xfilter[side] = (xpatterns){NULL, 0, 0, 0, NULL, 0, NULL, 0};
     }
-    xtest_console_out("white",     "===================================\n\n");
 } // end of func
 
 // ==============================================================================
@@ -220,109 +787,425 @@ static void xtest_output_report(xengine *runner) {
 
 // Prints usage instructions, including custom options, for a command-line program.
 static void xparser_print_usage(void) {
-    xtest_console_out("green",  "USAGE: Xcli [options]\n");
-    xtest_console_out("green", "Options:\n");
-    xtest_console_out("gray", "  -h, --help    Display this help message\n");
-    xtest_console_out("gray", "  -v, --version Display program version\n");
-    xtest_console_out("gray", "  --only-test   Run only test cases\n");
-    xtest_console_out("gray", "  --only-fish   Run only AI training cases\n");
-    xtest_console_out("gray", "  --only-mark   Run only benchmark cases\n");
-    xtest_console_out("gray", "  --cutback     Enable cutback mode\n");
-    xtest_console_out("gray", "  --verbose     Enable verbose mode\n");
-    xtest_console_out("gray", "  --repeat N    Repeat the test N times (requires a numeric argument)\n");
-} // end of func
-
-// Function to check if a specific option is present
-static bool xparser_has_option(int argc, char *argv[], const char *option) {
-    for (int32_t i = 1; i < argc; i++) {
-        if (strcmp(argv[i], option) == 0) {
-            return true;
+    xtest_console_out(XCOLOR_GREEN, "USAGE: Xcli [options]\n");
+    xtest_console_out(XCOLOR_GREEN, "Options (those taking a value also accept --key=value):\n");
+    xtest_console_out(XCOLOR_GRAY, "  -h, --help    Display this help message\n");
+    xtest_console_out(XCOLOR_GRAY, "  -v, --version Display program version\n");
+    xtest_console_out(XCOLOR_GRAY, "  --only-test   Run only test cases\n");
+    xtest_console_out(XCOLOR_GRAY, "  --only-fish   Run only AI training cases\n");
+    xtest_console_out(XCOLOR_GRAY, "  --only-mark   Run only benchmark cases\n");
+    xtest_console_out(XCOLOR_GRAY, "  --cutback     Enable cutback mode\n");
+    xtest_console_out(XCOLOR_GRAY, "  --verbose     Enable verbose mode\n");
+    xtest_console_out(XCOLOR_GRAY, "  --repeat N    Repeat each case N times (default 1)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --repeat-for T     Repeat the whole run for T (500ms, 30s, 10m, 2h), at most --repeat rounds if given\n");
+    xtest_console_out(XCOLOR_GRAY, "  --until-failure    Repeat the whole run until a case fails, capped by --repeat or --repeat-for\n");
+    xtest_console_out(XCOLOR_GRAY, "  --jobs N      Run cases on N worker threads (0 uses every core)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --isolate     Run cases in forked worker processes so crashes are contained\n");
+    xtest_console_out(XCOLOR_GRAY, "  --color       Force colored output even when stdout is not a terminal\n");
+    xtest_console_out(XCOLOR_GRAY, "  --no-color    Disable colored output\n");
+    xtest_console_out(XCOLOR_GRAY, "  --bench       Sample benchmark cases and report their statistics\n");
+    xtest_console_out(XCOLOR_GRAY, "  --bench-samples N  Samples collected per benchmark (default 20)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --bench-time MS    Minimum duration of one sample (default 5)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --bench-warmup MS  Warmup before sampling starts (default 50)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --save-baseline FILE     Write benchmark samples to FILE (implies --bench)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --compare-baseline FILE  Fail benchmarks significantly slower than FILE (implies --bench)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --tolerance PCT          Median change ignored by --compare-baseline (default 5)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --perf        Count cycles, instructions and misses of benchmarks (Linux, implies --bench)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --pin-cpu N   Sample benchmarks on core N only (with --bench, not with --jobs above 1)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --priority    Raise the scheduling priority of benchmark runs (with --bench, may need privileges)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --shard-index I    Run only the cases of shard I (0 based)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --shard-count N    Split the cases into N shards by name hash\n");
+    xtest_console_out(XCOLOR_GRAY, "  --report FILE      Write per-case results to FILE\n");
+    xtest_console_out(XCOLOR_GRAY, "  --merge-report FILE  Combine report files (repeatable) instead of running cases\n");
+    xtest_console_out(XCOLOR_GRAY, "  --timings FILE     Balance shards and jobs on durations recorded in FILE, then update it (shards leave it to --merge-report)\n");
+    xtest_console_out(XCOLOR_GRAY, "  --filter LIST      Run cases whose name or pool matches a glob in LIST (comma separated, '-' excludes)\n");
+} // end of func
+
+// Colors are only worth emitting on an interactive terminal that did not opt out
+static bool xparser_wants_color(void) {
+    if (getenv("NO_COLOR") != NULL) {
+        return false;
+    }
+#if defined(_WIN32)
+    return _isatty(_fileno(stdout)) != 0;
+#else
+    return isatty(fileno(stdout)) != 0;
+#endif
+}
+
+// Converts the value of a numeric option, exiting when it is malformed or out of range
+static long long xparser_number(const char *option, const char *text, long long min, long long max) {
+    char *end = NULL;
+    long long value = strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || value < min || value > max) {
+        xtest_console_err("Error: %s value must be between %lld and %lld.\n", option, min, max);
+        exit(EXIT_FAILURE);
+    }
+    return value;
+}
+
+// Converts a duration such as 500ms, 30s, 10m or 2h to nanoseconds; a bare
+// number counts seconds.
+static uint64_t xparser_duration(const char *option, const char *text) {
+    static const struct {
+        const char *suffix;
+        uint64_t ns;
+    } units[] = {
+        {"ns", 1ULL}, {"us", 1000ULL}, {"ms", 1000000ULL}, {"s", 1000000000ULL}, {"", 1000000000ULL},
+        {"m", 60ULL * 1000000000ULL}, {"h", 3600ULL * 1000000000ULL}
+    };
+
+    char *end = NULL;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end != text && *text != '-' && value > 0) {
+        for (size_t index = 0; index < sizeof(units) / sizeof(units[0]); index++) {
+            if (strcmp(end, units[index].suffix) == 0 && value <= UINT64_MAX / units[index].ns) {
+                return (uint64_t)value * units[index].ns;
+            }
         }
     }
-    return false;
+    xtest_console_err("Error: %s value must be a positive duration such as 500ms, 30s, 10m or 2h.\n", option);
+    exit(EXIT_FAILURE);
+}
+
+// Number of online processors used when --jobs is given zero
+static uint32_t xparser_count_cores(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0)? (uint32_t)info.dwNumberOfProcessors : 1;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0)? (uint32_t)cores : 1;
+#endif
+}
+
+// Every option the runner understands
+typedef enum {
+    XOPTION_HELP, XOPTION_VERSION, XOPTION_DRY_RUN, XOPTION_CUTBACK, XOPTION_VERBOSE,
+    XOPTION_ONLY_TEST, XOPTION_ONLY_FISH, XOPTION_ONLY_MARK, XOPTION_REPEAT, XOPTION_REPEAT_FOR,
+    XOPTION_UNTIL_FAILURE, XOPTION_JOBS,
+    XOPTION_ISOLATE, XOPTION_COLOR, XOPTION_NO_COLOR, XOPTION_BENCH, XOPTION_BENCH_SAMPLES,
+    XOPTION_BENCH_TIME, XOPTION_BENCH_WARMUP, XOPTION_SAVE_BASELINE, XOPTION_COMPARE_BASELINE,
+    XOPTION_TOLERANCE, XOPTION_PERF, XOPTION_PIN_CPU, XOPTION_PRIORITY, XOPTION_SHARD_INDEX,
+    XOPTION_SHARD_COUNT, XOPTION_REPORT, XOPTION_MERGE_REPORT, XOPTION_TIMINGS, XOPTION_FILTER
+} xoption_id;
+
+// How an option reads its value, from "--key=value" or the next argument
+typedef enum {
+    XVALUE_NONE,
+    XVALUE_NUMBER,        // Integer checked against min and max
+    XVALUE_TEXT
+} xvalue_kind;
+
+typedef struct {
+    const char *name;
+    xoption_id id;
+    xvalue_kind kind;
+    long long min;
+    long long max;
+} xoption;
+
+static const xoption XOPTIONS[] = {
+    {"--help", XOPTION_HELP, XVALUE_NONE, 0, 0},
+    {"-h", XOPTION_HELP, XVALUE_NONE, 0, 0},
+    {"--version", XOPTION_VERSION, XVALUE_NONE, 0, 0},
+    {"-v", XOPTION_VERSION, XVALUE_NONE, 0, 0},
+    {"--dry-run", XOPTION_DRY_RUN, XVALUE_NONE, 0, 0},
+    {"--cutback", XOPTION_CUTBACK, XVALUE_NONE, 0, 0},
+    {"--verbose", XOPTION_VERBOSE, XVALUE_NONE, 0, 0},
+    {"--only-test", XOPTION_ONLY_TEST, XVALUE_NONE, 0, 0},
+    {"--only-fish", XOPTION_ONLY_FISH, XVALUE_NONE, 0, 0},
+    {"--only-mark", XOPTION_ONLY_MARK, XVALUE_NONE, 0, 0},
+    {"--repeat", XOPTION_REPEAT, XVALUE_NUMBER, MIN_REPEATS, LLONG_MAX},
+    {"--repeat-for", XOPTION_REPEAT_FOR, XVALUE_TEXT, 0, 0},
+    {"--until-failure", XOPTION_UNTIL_FAILURE, XVALUE_NONE, 0, 0},
+    {"--jobs", XOPTION_JOBS, XVALUE_NUMBER, 0, MAX_JOBS},
+    {"--isolate", XOPTION_ISOLATE, XVALUE_NONE, 0, 0},
+    {"--color", XOPTION_COLOR, XVALUE_NONE, 0, 0},
+    {"--no-color", XOPTION_NO_COLOR, XVALUE_NONE, 0, 0},
+    {"--bench", XOPTION_BENCH, XVALUE_NONE, 0, 0},
+    {"--bench-samples", XOPTION_BENCH_SAMPLES, XVALUE_NUMBER, 2, MAX_SAMPLES},
+    {"--bench-time", XOPTION_BENCH_TIME, XVALUE_NUMBER, 1, 60000},
+    {"--bench-warmup", XOPTION_BENCH_WARMUP, XVALUE_NUMBER, 0, 60000},
+    {"--save-baseline", XOPTION_SAVE_BASELINE, XVALUE_TEXT, 0, 0},
+    {"--compare-baseline", XOPTION_COMPARE_BASELINE, XVALUE_TEXT, 0, 0},
+    {"--tolerance", XOPTION_TOLERANCE, XVALUE_NUMBER, 0, 1000},
+    {"--perf", XOPTION_PERF, XVALUE_NONE, 0, 0},
+    {"--pin-cpu", XOPTION_PIN_CPU, XVALUE_NUMBER, 0, MAX_JOBS - 1},
+    {"--priority", XOPTION_PRIORITY, XVALUE_NONE, 0, 0},
+    {"--shard-index", XOPTION_SHARD_INDEX, XVALUE_NUMBER, 0, MAX_SHARDS - 1},
+    {"--shard-count", XOPTION_SHARD_COUNT, XVALUE_NUMBER, 1, MAX_SHARDS},
+    {"--report", XOPTION_REPORT, XVALUE_TEXT, 0, 0},
+    {"--merge-report", XOPTION_MERGE_REPORT, XVALUE_TEXT, 0, 0},
+    {"--timings", XOPTION_TIMINGS, XVALUE_TEXT, 0, 0},
+    {"--filter", XOPTION_FILTER, XVALUE_TEXT, 0, 0}
+};
+
+// Finds the table entry spelled by the first length characters of name.
+static const xoption *xparser_lookup(const char *name, size_t length) {
+    for (size_t index = 0; index < sizeof(XOPTIONS) / sizeof(XOPTIONS[0]); index++) {
+        if (strncmp(XOPTIONS[index].name, name, length) == 0 && XOPTIONS[index].name[length] == '\0') {
+            return &XOPTIONS[index];
+        }
+    }
+    return NULL;
 }
 
-// Original xparser_parse_args function
+// Reads the command line in one pass; each argument is looked up in XOPTIONS
+// once, and later options override earlier ones.
 static void xparser_parse_args(int argc, char *argv[]) {
     xcli.cutback = false;
     xcli.verbose = false;
     xcli.dry_run = false;
     xcli.repeat  = false;
+    xcli.repeat_for_ns = 0;
+    xcli.until_failure = false;
     xcli.only_test = false;
+    xcli.only_fish = false;
     xcli.only_mark = false;
+    xcli.iter_repeat = 1;
+    xcli.jobs = 1;
+    xcli.isolate = false;
+    xcli.color = xparser_wants_color();
+    xcli.bench = false;
+    xcli.bench_samples = 20;
+    xcli.bench_sample_ns = 5 * 1000000ULL;
+    xcli.bench_warmup_ns = 50 * 1000000ULL;
+    xcli.save_baseline = NULL;
+    xcli.compare_baseline = NULL;
+    xcli.tolerance = 5.0;
+    xcli.perf = false;
+    xcli.pin_cpu = -1;
+    xcli.priority = false;
+    xcli.shard_index = 0;
+    xcli.shard_count = 1;
+    xcli.report = NULL;
+    xcli.merge = NULL;
+    xcli.merge_count = 0;
+    xcli.timings = NULL;
 
     for (int32_t i = 1; i < argc; i++) {
-        if (xparser_has_option(argc, argv, "--dry-run")) {
-            xcli.dry_run = true;
-        } else if (xparser_has_option(argc, argv, "--cutback")) {
-            xcli.cutback = true;
-            xcli.verbose = false;
-        } else if (xparser_has_option(argc, argv, "--verbose")) {
-            xcli.verbose = true;
-            xcli.cutback = false;
-        } else if (xparser_has_option(argc, argv, "--only-test")) {
-            xcli.only_test = true;
-            xcli.only_fish = false;
-            xcli.only_mark = false;
-        } else if (xparser_has_option(argc, argv, "--only-fish")) {
-            xcli.only_fish = true;
-            xcli.only_mark = false;
-            xcli.only_test = false;
-        } else if (xparser_has_option(argc, argv, "--only-mark")) {
-            xcli.only_mark = true;
-            xcli.only_fish = false;
-            xcli.only_test = false;
-        } else if (xparser_has_option(argc, argv, "--version") || xparser_has_option(argc, argv, "-v")) {
-            xtest_console_out("green", "1.1.1\n");
-            exit(EXIT_SUCCESS);
-        } else if (xparser_has_option(argc, argv, "--help") || xparser_has_option(argc, argv, "-h")) {
-            xparser_print_usage();
-            exit(EXIT_SUCCESS);
-        } else if (xparser_has_option(argc, argv, "--repeat")) {
-            xcli.repeat = true;
-            if (++i < argc) {
-                int iter_repeat = atoi(argv[i]);
-                if (iter_repeat >= MIN_REPEATS && iter_repeat <= MAX_REPEATS) {
-                    xcli.iter_repeat = iter_repeat;
-                } else {
-                    xtest_console_err("Error: --repeat value must be between 1 and 100.\n");
-                    exit(EXIT_FAILURE);
-                }
+        const char *arg = argv[i];
+        const char *equals = (arg[0] == '-' && arg[1] == '-')? strchr(arg, '=') : NULL;
+        size_t length = (equals != NULL)? (size_t)(equals - arg) : strlen(arg);
+        const xoption *option = xparser_lookup(arg, length);
+        if (option == NULL) {
+            xtest_console_err("Error: unknown option %.*s, see --help.\n", (int)length, arg);
+            exit(EXIT_FAILURE);
+        }
+
+        const char *text = NULL;
+        long long number = 0;
+        if (option->kind == XVALUE_NONE) {
+            if (equals != NULL) {
+                xtest_console_err("Error: %s option does not take a value.\n", option->name);
+                exit(EXIT_FAILURE);
+            }
+        } else {
+            if (equals != NULL) {
+                text = equals + 1;
+            } else if (i + 1 < argc) {
+                text = argv[++i];
             } else {
-                xtest_console_err("Error: --repeat option requires a numeric argument.\n");
+                xtest_console_err("Error: %s option requires %s argument.\n", option->name,
+                                  (option->kind == XVALUE_NUMBER)? "a numeric" : "an");
                 exit(EXIT_FAILURE);
             }
+            if (option->kind == XVALUE_NUMBER) {
+                number = xparser_number(option->name, text, option->min, option->max);
+            }
+        }
+
+        switch (option->id) {
+            case XOPTION_HELP:
+                xparser_print_usage();
+                exit(EXIT_SUCCESS);
+            case XOPTION_VERSION:
+                xtest_console_out(XCOLOR_GREEN, "1.1.1\n");
+                exit(EXIT_SUCCESS);
+            case XOPTION_DRY_RUN:
+                xcli.dry_run = true;
+                break;
+            case XOPTION_CUTBACK:
+                xcli.cutback = true;
+                xcli.verbose = false;
+                break;
+            case XOPTION_VERBOSE:
+                xcli.verbose = true;
+                xcli.cutback = false;
+                break;
+            case XOPTION_ONLY_TEST:
+            case XOPTION_ONLY_FISH:
+            case XOPTION_ONLY_MARK:
+                xcli.only_test = (option->id == XOPTION_ONLY_TEST);
+                xcli.only_fish = (option->id == XOPTION_ONLY_FISH);
+                xcli.only_mark = (option->id == XOPTION_ONLY_MARK);
+                break;
+            case XOPTION_REPEAT:
+                xcli.repeat = true;
+                xcli.iter_repeat = (uint64_t)number;
+                break;
+            case XOPTION_REPEAT_FOR:
+                xcli.repeat_for_ns = xparser_duration(option->name, text);
+                break;
+            case XOPTION_UNTIL_FAILURE:
+                xcli.until_failure = true;
+                break;
+            case XOPTION_JOBS:
+                xcli.jobs = (number == 0)? xparser_count_cores() : (uint32_t)number;
+                break;
+            case XOPTION_ISOLATE:
+                xcli.isolate = true;
+                break;
+            case XOPTION_COLOR:
+            case XOPTION_NO_COLOR:
+                xcli.color = (option->id == XOPTION_COLOR);
+                break;
+            case XOPTION_BENCH:
+                xcli.bench = true;
+                break;
+            case XOPTION_BENCH_SAMPLES:
+                xcli.bench_samples = (uint32_t)number;
+                break;
+            case XOPTION_BENCH_TIME:
+                xcli.bench_sample_ns = (uint64_t)number * 1000000ULL;
+                break;
+            case XOPTION_BENCH_WARMUP:
+                xcli.bench_warmup_ns = (uint64_t)number * 1000000ULL;
+                break;
+            case XOPTION_SAVE_BASELINE:
+                xcli.save_baseline = text;
+                xcli.bench = true;
+                break;
+            case XOPTION_COMPARE_BASELINE:
+                xcli.compare_baseline = text;
+                xcli.bench = true;
+                break;
+            case XOPTION_TOLERANCE:
+                xcli.tolerance = (double)number;
+                break;
+            case XOPTION_PERF:
+                xcli.perf = true;
+                xcli.bench = true;
+                break;
+            case XOPTION_PIN_CPU:
+                xcli.pin_cpu = (int32_t)number;
+                break;
+            case XOPTION_PRIORITY:
+                xcli.priority = true;
+                break;
+            case XOPTION_SHARD_INDEX:
+                xcli.shard_index = (uint32_t)number;
+                break;
+            case XOPTION_SHARD_COUNT:
+                xcli.shard_count = (uint32_t)number;
+                break;
+            case XOPTION_REPORT:
+                xcli.report = text;
+                break;
+            case XOPTION_MERGE_REPORT:
+                xcli.merge = (const char**)realloc((void*)xcli.merge, (xcli.merge_count + 1) * sizeof(*xcli.merge));
+                if (xcli.merge == NULL) {
+                    xtest_console_err("Error: Memory allocation failed\n");
+                    exit(EXIT_FAILURE);
+                }
+                xcli.merge[xcli.merge_count++] = text;
+                break;
+            case XOPTION_TIMINGS:
+                xcli.timings = text;
+                break;
+            case XOPTION_FILTER:
+                xfilter_add(text);
+                break;
         }
     }
+
+    if (xcli.shard_index >= xcli.shard_count) {
+        xtest_console_err("Error: --shard-index must be below --shard-count (%" PRIu32 ").\n", xcli.shard_count);
+        exit(EXIT_FAILURE);
+    }
+    // Parallel workers would share the one core and skew each other's samples
+    if (xcli.pin_cpu >= 0 && xcli.jobs > 1) {
+        xtest_console_err("Error: --pin-cpu samples on a single core and cannot be combined with --jobs above 1.\n");
+        exit(EXIT_FAILURE);
+    }
+    xfilter_compile();
 } // end of func
 
 // ==============================================================================
 // Xtest create and erase
 // ==============================================================================
 
+static void xengine_dispatch(xengine *engine);
+static void xtable_erase(xtable *table);
+static void xmark_run(xtable *table, size_t index);
+static void xmark_baseline(xengine *runner);
+static void xenv_prepare(void);
+static void xenv_report(void);
+static void xpool_enter(xtable *table, size_t index);
+static void xpool_leave(xtable *table, size_t index);
+static void xpool_release(xtable *table);
+static void xreport_write(const xengine *runner, const char *path);
+static void xreport_merge(xengine *runner);
+static void xtiming_record(const xtable *table, const char *path);
+
 // Initializes an xengine and processes command-line arguments.
 xengine xtest_create(int argc, char **argv) {
     xengine runner;
+    atexit(xoutput_release);
+    xtime_init();
     xparser_parse_args(argc, argv);
 
-    runner.stats = (xstats){0, 0, 0, 0, 0, 0, 0, 0};
-    runner.timer = (xtime){0, 0, 0};
+    runner.stats = (xstats){0};
+    runner.timer = (xtime){0, 0, 0, 0, 0, 0};
+    runner.table = (xtable){NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, XTEST_NO_POOL, NULL, 0, 0, 0};
+    runner.global = NULL;
 
     if (xcli.dry_run) { // Check if it's a dry run
-        xtest_console_out("blue", "Simulating config step...\n");
+        xtest_console_out(XCOLOR_BLUE, "Simulating config step...\n");
+    } else {
+        xenv_prepare();
     }
-    runner.timer.start = clock();
+    xtime_start(&runner.timer);
     return runner;
 } // end of func
 
 // Finalizes the execution of a Trilobite XUnit runner and displays test results.
 int xtest_erase(xengine *runner) {
+    if (xcli.merge_count > 0) {
+        xreport_merge(runner);
+    } else {
+        xengine_dispatch(runner);
+        xtime_stop(&runner->timer);
+    }
+
     if (xcli.dry_run) {
-        xtest_console_out("blue", "Simulating test results...\n");
+        xtest_console_out(XCOLOR_BLUE, "Simulating test results...\n");
+    } else if (xcli.merge_count > 0) {
+        xtest_output_report(runner);
     } else {
+        if (xcli.report != NULL) {
+            xreport_write(runner, xcli.report);
+        }
+        if (xcli.timings != NULL && xcli.shard_count <= 1) {
+            xtiming_record(&runner->table, xcli.timings);
+        }
+        xenv_report();
+        xmark_baseline(runner);
         xtest_output_report(runner);
     }
-    return runner->stats.failed_count;
+
+    xtable_erase(&runner->table);
+    xfilter_erase();
+    free((void*)xcli.merge);
+    xcli.merge = NULL;
+    xcli.merge_count = 0;
+    xoutput_flush();
+    fflush(stdout);
+
+    // The result becomes a process exit status, so keep it from wrapping to zero
+    return (runner->stats.failed_count > 255)? 255 : (int)runner->stats.failed_count;
 } // end of func
 
 // ==============================================================================
@@ -330,204 +1213,2513 @@ int xtest_erase(xengine *runner) {
 // ==============================================================================
 
 // Updates the statistics
-static void xtest_update_scoreboard(xengine* engine, xtest* test_case) {
+static void xtest_update_scoreboard(xstats* stats, uint8_t flags) {
     // Check if the test should be ignored
-    if (test_case->config.ignored) {
-        engine->stats.ignored_count++;
+    if (flags & XTEST_FLAG_IGNORED) {
+        stats->ignored_count++;
         return;
     }
-    if (XERRORS_TEST_CASE) {
-        engine->stats.error_count++;
+    if (flags & XTEST_FLAG_ERRORED) {
+        stats->error_count++;
         return;
     }
 
     // Update the appropriate count based on your logic
-    if (!test_case->config.is_mark && !test_case->config.is_fish) {
-        engine->stats.test_count++;
-    } else if (test_case->config.is_fish && !test_case->config.is_mark) {
-        engine->stats.fish_count++;
-    } else if (test_case->config.is_mark && !test_case->config.is_fish) {
-        engine->stats.mark_count++;
+    if (!(flags & (XTEST_FLAG_MARK | XTEST_FLAG_FISH))) {
+        stats->test_count++;
+    } else if (flags & XTEST_FLAG_FISH) {
+        stats->fish_count++;
+    } else {
+        stats->mark_count++;
     }
 
     // Update main score values
-    if (!XEXPECT_PASS_SCAN || !XASSERT_PASS_SCAN) {
-        engine->stats.failed_count++;
+    if (flags & XTEST_FLAG_FAILED) {
+        stats->failed_count++;
     } else {
-        engine->stats.passed_count++;
+        stats->passed_count++;
     }
-    engine->stats.total_count++;
+    stats->total_count++;
 } // end of func
 
 // Core steps to run a test case
-static void xtest_run(xtest* test_case, xfixture* fixture) {
-    test_case->timer.start = clock();
-
-    for (uint8_t iter = 0; iter < xcli.iter_repeat; iter++) {
+static void xtest_run(xtable* table, size_t index) {
+    void (*test_function)(void) = table->functions[index];
+    xfixture *fixture = table->fixtures[index];
+    xtest *test_case = table->cases[index];
+    xtime_start(&test_case->timer);
+
+    // --repeat alone repeats each case; the time-boxed and until-failure
+    // modes repeat the whole run instead, see xengine_dispatch_rounds
+    uint64_t limit = (xcli.repeat_for_ns > 0 || xcli.until_failure)? 1 : xcli.iter_repeat;
+    xctx.fastest_ns = UINT64_MAX;
+
+    for (xctx.iteration = 0; xctx.iteration < limit; ) {
         if (fixture && fixture->setup) {
             fixture->setup();
         }
 
-        test_case->test_function();
+        uint64_t begin = xtime_now();
+        if (test_case->config.range_max > 0) {
+            XMARK_RANGE_EACH(size, test_case->config) {
+                xctx.range_size = size;
+                test_function();
+            }
+        } else {
+            test_function();
+        }
+        uint64_t spent = xtime_now() - begin;
 
         if (fixture && fixture->teardown) {
             fixture->teardown();
         }
+
+        xctx.iteration++;
+        xctx.spent_ns += spent;
+        xctx.fastest_ns = (spent < xctx.fastest_ns)? spent : xctx.fastest_ns;
+        xctx.slowest_ns = (spent > xctx.slowest_ns)? spent : xctx.slowest_ns;
+        bool failed = !xctx.assert_pass || !xctx.expect_pass;
+        if (failed && xctx.failed_at == 0) {
+            xctx.failed_at = xctx.iteration;
+        }
+        if (xctx.ignored || xctx.errored) {
+            break;
+        }
     }
 
-    test_case->timer.end = clock(); // Calculate elapsed time and store it in the test case
-    test_case->timer.elapsed = ((double)(test_case->timer.end - test_case->timer.start)  / CLOCKS_PER_SEC) * 1000.0;
+    xtime_stop(&test_case->timer); // Calculate elapsed time and store it in the test case
+    table->durations[index] = test_case->timer.elapsed;
 } // end of func
 
 // Common functionality for running a test case.
-static void xtest_run_test(xengine* engine, xtest* test_case, xfixture* fixture) {
-    xtest_output_start(test_case, engine);
+static void xtest_run_test(xstats* stats, xtable* table, size_t index) {
+    xtest *test_case = table->cases[index];
+    xctx.hushed = (xround > 0);
+    xtest_output_start(test_case, index);
 
-    if (!xcli.dry_run && !XIGNORE_TEST_CASE) {
-        xtest_run(test_case, fixture);
+    if (xcli.dry_run) {
+        xtest_console_out(XCOLOR_BLUE, "Simulating test case...\n");
+        return;
+    }
 
-    } else if (!xcli.dry_run && XIGNORE_TEST_CASE) {
-        test_case->config.ignored = XIGNORE_TEST_CASE;
-        XIGNORE_TEST_CASE = false;
+    xpool_enter(table, index);
+    xctx = (xcontext){.assert_pass = true, .expect_pass = true, .hushed = (xround > 0)};
+    if (xcli.bench && (table->flags[index] & XTEST_FLAG_MARK)) {
+        xmark_run(table, index);
+    } else {
+        xtest_run(table, index);
+    }
+    if (xctx.ignored) {
+        table->flags[index] |= XTEST_FLAG_IGNORED;
+    }
+    test_case->config.ignored = xctx.ignored;
+    if (!xctx.ignored && !xctx.errored && (!xctx.expect_pass || !xctx.assert_pass)) {
+        table->flags[index] |= XTEST_FLAG_FAILED;
+    }
+    if (!xctx.ignored && xctx.errored) {
+        table->flags[index] |= XTEST_FLAG_ERRORED;
+    }
 
-    } else if (xcli.dry_run) {
-        xtest_console_out("blue", "Simulating test case...\n");
-        return;
+    xtest_update_scoreboard(stats, table->flags[index]);
+    if (!(table->flags[index] & (XTEST_FLAG_IGNORED | XTEST_FLAG_ERRORED))) {
+        stats->iteration_count += (xctx.iteration > 0)? xctx.iteration : 1;
     }
+    xtest_output_end(test_case);
+    xpool_leave(table, index);
 
-    xtest_update_scoreboard(engine, test_case);
-    xtest_output_end(test_case, engine);
+    // Write each finished case out whole, so several jobs never interleave
+    // inside a case and a later crash or hang cannot swallow its output
+    xoutput_flush();
+    fflush(stdout);
 } // end of func
 
 // ==============================================================================
-// Xtest essential test runner functions
+// Xtest timing database
 // ==============================================================================
 
-void xtest_run_as_test(xengine* engine, xtest* test_case) {
-    test_case->config.ignored = false;
-    xtest_run_test(engine, test_case, NULL);
+// Duration of one case recorded by an earlier run
+typedef struct {
+    char *name;
+    uint64_t duration;    // Nanoseconds the case took when it last ran
+    bool seen;            // The case ran again, so its new duration replaces this one
+} xtiming;
+
+// Entries of --timings, sorted by name for lookups
+static xtiming *xtimings = NULL;
+static size_t xtiming_count = 0;
+
+// Skips the '#' comment lines at the top of a results file.
+static void xfile_skip_comments(FILE *file) {
+    int c = fgetc(file);
+    while (c == '#') {
+        while (c != '\n' && c != EOF) {
+            c = fgetc(file);
+        }
+        c = fgetc(file);
+    }
+    if (c != EOF) {
+        ungetc(c, file);
+    }
 } // end of func
 
-void xtest_run_as_fixture(xengine* engine, xtest* test_case, xfixture* fixture) {
-    test_case->config.ignored = false;
-    xtest_run_test(engine, test_case, fixture);
+static int xtiming_compare(const void *left, const void *right) {
+    return strcmp(((const xtiming*)left)->name, ((const xtiming*)right)->name);
 } // end of func
 
-// ==============================================================================
-// Xmark functions for benchmarks
-// ==============================================================================
-
-void xmark_start_benchmark() {
-#if defined(_WIN32)
-    LARGE_INTEGER freq;
-    QueryPerformanceFrequency(&freq);
-    frequency = (double)freq.QuadPart;
-    QueryPerformanceCounter((LARGE_INTEGER*)&start_time);
-#else
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    start_time = ts.tv_sec * 1e9 + ts.tv_nsec;
-#endif
-}
-
-uint64_t xmark_stop_benchmark() {
-#if defined(_WIN32)
-    LARGE_INTEGER end_time;
-    QueryPerformanceCounter(&end_time);
-    return (uint64_t)((end_time.QuadPart - start_time) * 1e9 / frequency);
-#else
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (ts.tv_sec * 1e9 + ts.tv_nsec) - start_time;
-#endif
-}
+static xtiming *xtiming_find(const char *name) {
+    xtiming key = {(char*)name, 0, false};
+    return (xtiming*)bsearch(&key, xtimings, xtiming_count, sizeof(xtiming), xtiming_compare);
+} // end of func
 
-void xmark_assert_seconds(uint64_t elapsed_time_ns, double max_seconds) {
-    if (!XASSERT_PASS_SCAN) {
+// Seeds the duration column from --timings; a missing file is a first run.
+static void xtiming_load(xtable *table, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
         return;
     }
-    double elapsed_seconds = elapsed_time_ns / 1e9;
-    if (elapsed_seconds > max_seconds) {
-        XASSERT_PASS_SCAN = false;
-        if (xcli.verbose && !xcli.cutback) {
-            xtest_console_out("blue", "[XMARK ISSUE]\n");
-            xtest_console_out("red", "Elapsed time (%f min)\n", elapsed_seconds);
-            xtest_console_out("red", "Exceeds limit (%f min)\n", max_seconds);
-        } else if (!xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "Benchmark failed: elapsed time (%f min) exceeds limit (%f min)\n", elapsed_seconds, max_seconds);
-        } else if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "[F]");
+    xfile_skip_comments(file);
+
+    char name[256];
+    uint64_t duration = 0;
+    size_t capacity = 0;
+    while (fscanf(file, "%255s %" SCNu64, name, &duration) == 2) {
+        if (xtiming_count == capacity) {
+            capacity = (capacity)? capacity * 2 : 256;
+            xtimings = (xtiming*)realloc(xtimings, capacity * sizeof(xtiming));
         }
-    } else {
-        if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("green", "[P]");
+        size_t length = strlen(name) + 1;
+        char *copy = (char*)malloc(length);
+        if (xtimings == NULL || copy == NULL) {
+            xtest_console_err("Error: Memory allocation failed for timings.\n");
+            exit(EXIT_FAILURE);
         }
+        memcpy(copy, name, length);
+        xtimings[xtiming_count++] = (xtiming){copy, duration, false};
+    }
+    fclose(file);
+    if (xtiming_count > 0) {
+        qsort(xtimings, xtiming_count, sizeof(xtiming), xtiming_compare);
     }
-}
+
+    for (size_t index = 0; index < table->count; index++) {
+        const xtiming *timing = xtiming_find(table->cases[index]->name);
+        table->durations[index] = (timing != NULL)? timing->duration : 0;
+    }
+} // end of func
+
+// Rewrites --timings with the fresh durations, keeping the entries of cases
+// that filters skipped this time.
+static void xtiming_save(const char *path, const xtiming *fresh, size_t count) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        xtest_console_err("Error: cannot write timings file %s.\n", path);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(file, "# xtest timings\n");
+    for (size_t position = 0; position < count; position++) {
+        xtiming *timing = xtiming_find(fresh[position].name);
+        if (timing != NULL) {
+            timing->seen = true;
+        }
+        fprintf(file, "%s %" PRIu64 "\n", fresh[position].name, fresh[position].duration);
+    }
+    for (size_t entry = 0; entry < xtiming_count; entry++) {
+        if (!xtimings[entry].seen) {
+            fprintf(file, "%s %" PRIu64 "\n", xtimings[entry].name, xtimings[entry].duration);
+        }
+        free(xtimings[entry].name);
+    }
+    fclose(file);
+
+    free(xtimings);
+    xtimings = NULL;
+    xtiming_count = 0;
+} // end of func
+
+// Saves the durations of the cases that ran. Shards leave the file alone:
+// they all pack from the same snapshot, and --merge-report folds their
+// durations back in once every shard is done.
+static void xtiming_record(const xtable *table, const char *path) {
+    xtiming *fresh = (xtiming*)malloc(((table->selected)? table->selected : 1) * sizeof(xtiming));
+    if (fresh == NULL) {
+        xtest_console_err("Error: Memory allocation failed for timings.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t position = 0; position < table->selected; position++) {
+        size_t index = table->order[position];
+        fresh[position] = (xtiming){(char*)table->cases[index]->name, table->durations[index], true};
+    }
+    xtiming_save(path, fresh, table->selected);
+    free(fresh);
+} // end of func
+
+// ==============================================================================
+// Xtest case table
+// ==============================================================================
+
+// Resizes one column of the table, exiting when memory runs out.
+static void *xtable_column(void *column, size_t capacity, size_t size) {
+    void *resized = realloc(column, capacity * size);
+    if (resized == NULL) {
+        xtest_console_err("Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return resized;
+} // end of func
+
+// Appends a case to the table, splitting it across the hot and cold columns.
+static void xtable_append(xtable* table, xtest* test_case, xfixture* fixture) {
+    if (test_case->config.range_min > test_case->config.range_max) {
+        xtest_console_err("Error: benchmark %s sweeps from %" PRIu64 " down to %" PRIu64 ", the first size must not exceed the last.\n",
+                          test_case->name, test_case->config.range_min, test_case->config.range_max);
+        exit(EXIT_FAILURE);
+    }
+    if (table->count == table->capacity) {
+        size_t capacity = (table->capacity)? table->capacity * 2 : 64;
+        table->functions = (void (**)(void))xtable_column((void*)table->functions, capacity, sizeof(*table->functions));
+        table->fixtures = (xfixture**)xtable_column(table->fixtures, capacity, sizeof(*table->fixtures));
+        table->flags = (uint8_t*)xtable_column(table->flags, capacity, sizeof(*table->flags));
+        table->durations = (uint64_t*)xtable_column(table->durations, capacity, sizeof(*table->durations));
+        table->cases = (xtest**)xtable_column(table->cases, capacity, sizeof(*table->cases));
+        table->groups = (uint32_t*)xtable_column(table->groups, capacity, sizeof(*table->groups));
+        table->capacity = capacity;
+    }
+
+    size_t index = table->count++;
+    table->functions[index] = test_case->test_function;
+    table->fixtures[index] = fixture;
+    table->flags[index] = (uint8_t)((test_case->config.is_mark? XTEST_FLAG_MARK : 0) |
+                                    (test_case->config.is_fish? XTEST_FLAG_FISH : 0));
+    table->durations[index] = 0;
+    table->cases[index] = test_case;
+    table->groups[index] = table->current;
+} // end of func
+
+// FNV-1a of a case name, so every machine assigns a case to the same shard.
+static uint64_t xtable_hash(const char *name) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *cursor = (const unsigned char*)name; *cursor; cursor++) {
+        hash = (hash ^ *cursor) * 1099511628211ULL;
+    }
+    return hash;
+} // end of func
+
+// A case waiting for a bin in xtable_balance
+typedef struct {
+    uint64_t weight;
+    size_t position;
+} xjob;
+
+// Heaviest first, ties in queue order so every machine packs alike.
+static int xjob_compare(const void *left, const void *right) {
+    const xjob *a = (const xjob*)left;
+    const xjob *b = (const xjob*)right;
+    if (a->weight != b->weight) {
+        return (a->weight < b->weight)? 1 : -1;
+    }
+    return (a->position > b->position) - (a->position < b->position);
+} // end of func
+
+static bool xbin_lighter(const uint64_t *loads, uint32_t a, uint32_t b) {
+    return loads[a] < loads[b] || (loads[a] == loads[b] && a < b);
+} // end of func
+
+// Longest processing time first: each case, heaviest first, goes to the least
+// loaded bin, kept on top of a min-heap. Cases missing from the timing database
+// weigh the mean of the others. Fills bins per position of order and, when
+// sorted is given, the positions in the order they were placed.
+static void xtable_balance(const xtable *table, const size_t *order, size_t count, uint32_t bin_count, uint32_t *bins, size_t *sorted) {
+    xjob *jobs = (xjob*)malloc((count? count : 1) * sizeof(xjob));
+    uint64_t *loads = (uint64_t*)calloc(bin_count, sizeof(uint64_t));
+    uint32_t *heap = (uint32_t*)malloc(bin_count * sizeof(uint32_t));
+    if (jobs == NULL || loads == NULL || heap == NULL) {
+        xtest_console_err("Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t known = 0;
+    uint64_t total = 0;
+    for (size_t position = 0; position < count; position++) {
+        uint64_t duration = table->durations[order[position]];
+        known += (duration > 0);
+        total += duration;
+    }
+    uint64_t mean = (known > 0)? total / known : 1;
+    for (size_t position = 0; position < count; position++) {
+        uint64_t duration = table->durations[order[position]];
+        jobs[position] = (xjob){(duration > 0)? duration : mean, position};
+    }
+    qsort(jobs, count, sizeof(xjob), xjob_compare);
+
+    // Every load starts at zero, so bins in index order already form a heap
+    for (uint32_t bin = 0; bin < bin_count; bin++) {
+        heap[bin] = bin;
+    }
+    for (size_t job = 0; job < count; job++) {
+        uint32_t bin = heap[0];
+        bins[jobs[job].position] = bin;
+        if (sorted != NULL) {
+            sorted[job] = jobs[job].position;
+        }
+        loads[bin] += jobs[job].weight;
+
+        size_t node = 0;
+        for (;;) {
+            size_t child = 2 * node + 1;
+            if (child >= bin_count) {
+                break;
+            }
+            if (child + 1 < bin_count && xbin_lighter(loads, heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!xbin_lighter(loads, heap[child], heap[node])) {
+                break;
+            }
+            uint32_t swap = heap[child];
+            heap[child] = heap[node];
+            heap[node] = swap;
+            node = child;
+        }
+    }
+
+    free(jobs);
+    free(loads);
+    free(heap);
+} // end of func
+
+// Keeps the selected cases of --shard-index: packed on recorded durations when
+// a timing database is loaded, spread by name hash otherwise.
+static void xtable_shard(xtable *table) {
+    uint32_t *bins = NULL;
+    if (xtiming_count > 0) {
+        bins = (uint32_t*)xtable_column(NULL, (table->selected)? table->selected : 1, sizeof(*bins));
+        xtable_balance(table, table->order, table->selected, xcli.shard_count, bins, NULL);
+    }
+
+    size_t kept = 0;
+    for (size_t position = 0; position < table->selected; position++) {
+        size_t index = table->order[position];
+        uint32_t bin = (bins)? bins[position] : (uint32_t)(xtable_hash(table->cases[index]->name) % xcli.shard_count);
+        table->order[kept] = index;
+        kept += (bin == xcli.shard_index);
+    }
+    table->selected = kept;
+    free(bins);
+} // end of func
+
+// Counts the selected cases of each pool, so pool fixtures tear down when
+// their last selected case finishes.
+static void xtable_arm_pools(xtable *table) {
+    for (size_t group = 0; group < table->pool_count; group++) {
+        table->pools[group].pending = 0;
+        table->pools[group].state = 0;
+    }
+    for (size_t position = 0; position < table->selected; position++) {
+        uint32_t group = table->groups[table->order[position]];
+        if (group != XTEST_NO_POOL) {
+            table->pools[group].pending++;
+        }
+    }
+} // end of func
+
+// Builds the run order with one pass over the flag column for the --only-* options.
+static void xtable_select(xtable* table) {
+    uint8_t mask = 0;
+    uint8_t want = 0;
+    if (xcli.only_test) {
+        mask = XTEST_FLAG_MARK | XTEST_FLAG_FISH;
+    } else if (xcli.only_mark) {
+        mask = want = XTEST_FLAG_MARK;
+    } else if (xcli.only_fish) {
+        mask = want = XTEST_FLAG_FISH;
+    }
+
+    if (xcli.bench && table->marks == NULL) {
+        table->marks = (xmark_stats*)calloc((table->count)? table->count : 1, sizeof(*table->marks));
+        if (table->marks == NULL) {
+            xtest_console_err("Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    free(table->order);
+    table->order = (size_t*)xtable_column(NULL, (table->count)? table->count : 1, sizeof(*table->order));
+    bool filtered = xfilter[0].count + xfilter[1].count > 0;
+    table->selected = 0;
+    for (size_t index = 0; index < table->count; index++) {
+        table->order[table->selected] = index;
+        bool wanted = ((table->flags[index] & mask) == want);
+        if (wanted && filtered) {
+            uint32_t group = table->groups[index];
+            wanted = xfilter_accepts(table->cases[index]->name, (group != XTEST_NO_POOL)? table->pools[group].name : NULL);
+        }
+        table->selected += wanted;
+    }
+    if (filtered) {
+        xfilter_report_unused(table);
+    }
+    if (xcli.shard_count > 1) {
+        xtable_shard(table);
+    }
+    xtable_arm_pools(table);
+} // end of func
+
+static void xtable_erase(xtable* table) {
+    for (size_t index = 0; table->marks && index < table->count; index++) {
+        free(table->marks[index].values);
+    }
+    free(table->marks);
+    free((void*)table->functions);
+    free(table->fixtures);
+    free(table->flags);
+    free(table->durations);
+    free(table->cases);
+    free(table->order);
+    free(table->groups);
+    free(table->pools);
+    *table = (xtable){NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, XTEST_NO_POOL, NULL, 0, 0, 0};
+} // end of func
+
+// ==============================================================================
+// Xtest shard reports
+// ==============================================================================
+
+static const char *XREPORT_KINDS[] = {"test", "mark", "fish"};
+static const char *XREPORT_STATES[] = {"pass", "fail", "skip", "error"};
+
+// Writes one line per case that ran, in a form --merge-report can add back up.
+static void xreport_write(const xengine *runner, const char *path) {
+    const xtable *table = &runner->table;
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        xtest_console_err("Error: cannot write report file %s.\n", path);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(file, "# xtest report shard=%" PRIu32 "/%" PRIu32 " elapsed=%" PRIu64 "\n",
+            xcli.shard_index, xcli.shard_count, runner->timer.elapsed);
+    for (size_t position = 0; position < table->selected; position++) {
+        size_t index = table->order[position];
+        uint8_t flags = table->flags[index];
+        size_t kind = (flags & XTEST_FLAG_MARK)? 1 : (flags & XTEST_FLAG_FISH)? 2 : 0;
+        size_t state = (flags & XTEST_FLAG_IGNORED)? 2 : (flags & XTEST_FLAG_ERRORED)? 3 : (flags & XTEST_FLAG_FAILED)? 1 : 0;
+        fprintf(file, "%s %s %s %" PRIu64 "\n", table->cases[index]->name,
+                XREPORT_KINDS[kind], XREPORT_STATES[state], table->durations[index]);
+    }
+    fclose(file);
+} // end of func
+
+// Index of word in a table of names, or count when it is not there.
+static size_t xreport_lookup(const char **names, size_t count, const char *word) {
+    size_t index = 0;
+    while (index < count && strcmp(names[index], word) != 0) {
+        index++;
+    }
+    return index;
+} // end of func
+
+// Fails the merge unless the reports name every selected case exactly once,
+// so shards that split the cases differently cannot pass unnoticed.
+static void xreport_cover(xtable *table, xtiming *merged, size_t count) {
+    qsort(merged, count, sizeof(xtiming), xtiming_compare);
+    for (size_t entry = 1; entry < count; entry++) {
+        if (strcmp(merged[entry - 1].name, merged[entry].name) == 0) {
+            xtest_console_err("Error: case %s ran in more than one shard.\n", merged[entry].name);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    xtable_select(table);
+    size_t missing = 0;
+    const char *first = NULL;
+    for (size_t position = 0; position < table->selected; position++) {
+        xtiming key = {(char*)table->cases[table->order[position]]->name, 0, false};
+        if (bsearch(&key, merged, count, sizeof(xtiming), xtiming_compare) == NULL) {
+            first = (first)? first : key.name;
+            missing++;
+        }
+    }
+    if (missing > 0) {
+        xtest_console_err("Error: %zu of %zu cases ran in no shard, first %s.\n", missing, table->selected, first);
+        exit(EXIT_FAILURE);
+    }
+    if (count != table->selected) {
+        xtest_console_err("Error: the reports name %zu cases this run does not select.\n", count - table->selected);
+        exit(EXIT_FAILURE);
+    }
+} // end of func
+
+// Rebuilds the scoreboard from the --merge-report files; the elapsed time is
+// that of the slowest shard, since shards run side by side. With --timings
+// the merged durations replace those the shards started from.
+static void xreport_merge(xengine *runner) {
+    xtiming *merged = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    for (uint32_t file_index = 0; file_index < xcli.merge_count; file_index++) {
+        const char *path = xcli.merge[file_index];
+        FILE *file = fopen(path, "r");
+        if (file == NULL) {
+            xtest_console_err("Error: cannot open report file %s.\n", path);
+            exit(EXIT_FAILURE);
+        }
+
+        uint64_t elapsed = 0;
+        if (fscanf(file, "# xtest report shard=%*u/%*u elapsed=%" SCNu64, &elapsed) == 1 && elapsed > runner->timer.elapsed) {
+            runner->timer.elapsed = elapsed;
+        }
+
+        char name[256], kind[8], state[8];
+        uint64_t duration = 0;
+        while (fscanf(file, "%255s %7s %7s %" SCNu64, name, kind, state, &duration) == 4) {
+            size_t k = xreport_lookup(XREPORT_KINDS, 3, kind);
+            size_t s = xreport_lookup(XREPORT_STATES, 4, state);
+            if (k == 3 || s == 4) {
+                xtest_console_err("Error: malformed report file %s.\n", path);
+                exit(EXIT_FAILURE);
+            }
+
+            if (count == capacity) {
+                capacity = (capacity)? capacity * 2 : 256;
+                merged = (xtiming*)realloc(merged, capacity * sizeof(xtiming));
+            }
+            size_t length = strlen(name) + 1;
+            char *copy = (char*)malloc(length);
+            if (merged == NULL || copy == NULL) {
+                xtest_console_err("Error: Memory allocation failed for reports.\n");
+                exit(EXIT_FAILURE);
+            }
+            memcpy(copy, name, length);
+            merged[count++] = (xtiming){copy, duration, false};
+
+            xstats *stats = &runner->stats;
+            if (s == 2) {
+                stats->ignored_count++;
+                continue;
+            }
+            if (s == 3) {
+                stats->error_count++;
+                continue;
+            }
+            stats->test_count += (k == 0);
+            stats->mark_count += (k == 1);
+            stats->fish_count += (k == 2);
+            stats->passed_count += (s == 0);
+            stats->failed_count += (s == 1);
+            stats->total_count++;
+        }
+        if (!feof(file)) {
+            xtest_console_err("Error: malformed report file %s.\n", path);
+            exit(EXIT_FAILURE);
+        }
+        fclose(file);
+    }
+
+    if (runner->table.count > 0) {
+        xreport_cover(&runner->table, merged, count);
+    }
+    if (xcli.timings != NULL) {
+        xtiming_load(&runner->table, xcli.timings);
+        xtiming_save(xcli.timings, merged, count);
+    }
+    for (size_t entry = 0; entry < count; entry++) {
+        free(merged[entry].name);
+    }
+    free(merged);
+} // end of func
+
+// ==============================================================================
+// Xtest static registry
+// ==============================================================================
+
+// Section bounds provided by the linker (or by the $a/$z sentinels on MSVC)
+#if defined(_MSC_VER)
+__declspec(allocate("xtest$a")) static xtest *xregistry_begin = NULL;
+__declspec(allocate("xtest$z")) static xtest *xregistry_end = NULL;
+#elif defined(__APPLE__)
+extern xtest *xregistry_begin __asm("section$start$__DATA$xtest_cases");
+extern xtest *xregistry_end __asm("section$end$__DATA$xtest_cases");
+#else
+extern xtest *__start_xtest_cases[] __attribute__((weak));
+extern xtest *__stop_xtest_cases[] __attribute__((weak));
+#endif
+
+// Returns the registration section as a pointer range; empty when no case was linked.
+static void xregistry_bounds(xtest ***begin, xtest ***end) {
+#if defined(_MSC_VER) || defined(__APPLE__)
+    *begin = &xregistry_begin;
+    *end = &xregistry_end;
+#if defined(_MSC_VER)
+    *begin += 1;
+#endif
+#else
+    *begin = __start_xtest_cases;
+    *end = __stop_xtest_cases;
+    if (*begin == NULL || *end == NULL) {
+        *end = *begin;
+    }
+#endif
+} // end of func
+
+// ==============================================================================
+// Xtest essential test runner functions
+// ==============================================================================
+
+void xtest_run_as_test(xengine* engine, xtest* test_case) {
+    test_case->config.ignored = false;
+    xtable_append(&engine->table, test_case, NULL);
+} // end of func
+
+void xtest_run_as_fixture(xengine* engine, xtest* test_case, xfixture* fixture) {
+    test_case->config.ignored = false;
+    xtable_append(&engine->table, test_case, fixture);
+} // end of func
+
+// Queues the cases of one pool, tagging them so a pool fixture can wrap them.
+void xtest_import_pool(xengine* engine, const char *name, void (*pool)(xengine *runner)) {
+    xtable *table = &engine->table;
+    if (table->pool_count == table->pool_capacity) {
+        table->pool_capacity = (table->pool_capacity)? table->pool_capacity * 2 : 16;
+        table->pools = (xpool*)xtable_column(table->pools, table->pool_capacity, sizeof(*table->pools));
+    }
+    table->pools[table->pool_count] = (xpool){name, NULL, 0, 0};
+    table->current = (uint32_t)table->pool_count++;
+    pool(engine);
+    table->current = XTEST_NO_POOL;
+} // end of func
+
+void xtest_pool_fixture(xengine* engine, xfixture* fixture) {
+    xtable *table = &engine->table;
+    if (table->current == XTEST_NO_POOL) {
+        xtest_console_err("Error: XTEST_POOL_FIXTURE used outside a pool imported with XTEST_IMPORT_POOL.\n");
+        exit(EXIT_FAILURE);
+    }
+    table->pools[table->current].fixture = fixture;
+} // end of func
+
+void xtest_global_fixture(xengine* engine, xfixture* fixture) {
+    engine->global = fixture;
+} // end of func
+
+void xtest_run_registered(xengine* engine) {
+    xtest **begin = NULL;
+    xtest **end = NULL;
+    xregistry_bounds(&begin, &end);
+
+    for (xtest **entry = begin; entry < end; entry++) {
+        // MSVC may pad the section between object files with zeros
+        if (*entry == NULL) {
+            continue;
+        }
+        xtest *test_case = *entry;
+        bool fixtured = test_case->fixture.setup || test_case->fixture.teardown;
+        test_case->config.ignored = false;
+        xtable_append(&engine->table, test_case, fixtured? &test_case->fixture : NULL);
+    }
+} // end of func
+
+// ==============================================================================
+// Xtest parallel dispatch
+// ==============================================================================
+
+#if defined(_WIN32)
+typedef HANDLE xthread;
+#else
+typedef pthread_t xthread;
+#endif
+
+typedef struct {
+    volatile int64_t top;     // Next slot thieves steal from
+    volatile int64_t bottom;  // One past the slot the owner pops next
+    size_t *items;            // Queue indices, filled once before the run
+} xdeque;
+
+typedef struct xworker {
+    xengine *engine;          // Engine owning the case table
+    struct xworker *peers;    // Every worker, so idle ones can steal
+    uint32_t count;           // Number of workers in peers
+    uint32_t id;              // Index of this worker in peers
+    xdeque deque;             // Cases owned by this worker
+    uint8_t spacer[64];       // Keeps thieves touching the deque off the scoreboard line
+    xstats stats;             // Scoreboard local to this worker, merged once at the end
+    uint8_t tail[64];         // Keeps the next worker in the array off this line
+} xworker;
+
+// Thin wrappers over the compiler atomics used by the deques.
+static int64_t xatomic_load(volatile int64_t *value) {
+#if defined(_MSC_VER)
+    return InterlockedCompareExchange64((volatile LONG64*)value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void xatomic_store(volatile int64_t *value, int64_t desired) {
+#if defined(_MSC_VER)
+    InterlockedExchange64((volatile LONG64*)value, desired);
+#else
+    __atomic_store_n(value, desired, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static bool xatomic_cas(volatile int64_t *value, int64_t expected, int64_t desired) {
+#if defined(_MSC_VER)
+    return InterlockedCompareExchange64((volatile LONG64*)value, desired, expected) == expected;
+#else
+    return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+#endif
+}
+
+static void xatomic_fence(void) {
+#if defined(_MSC_VER)
+    MemoryBarrier();
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+// ==============================================================================
+// Xtest pool fixtures
+// ==============================================================================
+
+enum { XPOOL_IDLE, XPOOL_SETUP, XPOOL_READY, XPOOL_DONE };
+
+static void xthread_yield(void) {
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+} // end of func
+
+// The first case of a pool to start runs its setup; cases of the same pool
+// starting meanwhile on other workers wait until the setup is finished.
+static void xpool_enter(xtable *table, size_t index) {
+    uint32_t group = table->groups[index];
+    if (group == XTEST_NO_POOL || table->pools[group].fixture == NULL) {
+        return;
+    }
+    xpool *pool = &table->pools[group];
+    if (xatomic_cas(&pool->state, XPOOL_IDLE, XPOOL_SETUP)) {
+        if (pool->fixture->setup) {
+            pool->fixture->setup();
+        }
+        xatomic_store(&pool->state, XPOOL_READY);
+    }
+    while (xatomic_load(&pool->state) == XPOOL_SETUP) {
+        xthread_yield();
+    }
+} // end of func
+
+// The last case of a pool to finish runs its teardown.
+static void xpool_leave(xtable *table, size_t index) {
+    uint32_t group = table->groups[index];
+    if (group == XTEST_NO_POOL || table->pools[group].fixture == NULL) {
+        return;
+    }
+    xpool *pool = &table->pools[group];
+    int64_t pending = 0;
+    do {
+        pending = xatomic_load(&pool->pending);
+    } while (!xatomic_cas(&pool->pending, pending, pending - 1));
+
+    if (pending == 1 && xatomic_cas(&pool->state, XPOOL_READY, XPOOL_DONE) && pool->fixture->teardown) {
+        pool->fixture->teardown();
+    }
+} // end of func
+
+// Tears down one pool if this process set it up and has not torn it down yet.
+static void xpool_finish(xpool *pool) {
+    if (pool->fixture && xatomic_cas(&pool->state, XPOOL_READY, XPOOL_DONE) && pool->fixture->teardown) {
+        pool->fixture->teardown();
+    }
+} // end of func
+
+// Tears down pools left set up, as in an isolated worker that only ran part of a pool.
+static void xpool_release(xtable *table) {
+    for (size_t group = 0; group < table->pool_count; group++) {
+        xpool_finish(&table->pools[group]);
+    }
+} // end of func
+
+// Owner side of the Chase-Lev deque: takes from the bottom end.
+static bool xdeque_pop(xdeque *deque, size_t *item) {
+    int64_t bottom = xatomic_load(&deque->bottom) - 1;
+    xatomic_store(&deque->bottom, bottom);
+    xatomic_fence();
+    int64_t top = xatomic_load(&deque->top);
+
+    if (top > bottom) {
+        xatomic_store(&deque->bottom, bottom + 1);
+        return false;
+    }
+
+    *item = deque->items[bottom];
+    if (top == bottom) {
+        // Last item, race any thief for it
+        bool won = xatomic_cas(&deque->top, top, top + 1);
+        xatomic_store(&deque->bottom, bottom + 1);
+        return won;
+    }
+    return true;
+} // end of func
+
+// Thief side of the Chase-Lev deque: takes from the top end.
+static bool xdeque_steal(xdeque *deque, size_t *item, bool *empty) {
+    int64_t top = xatomic_load(&deque->top);
+    xatomic_fence();
+    int64_t bottom = xatomic_load(&deque->bottom);
+
+    *empty = (top >= bottom);
+    if (*empty) {
+        return false;
+    }
+
+    *item = deque->items[top];
+    return xatomic_cas(&deque->top, top, top + 1);
+} // end of func
+
+// Scans the peers once, returning false only when every deque was seen empty.
+static bool xworker_steal(xworker *worker, size_t *item, bool *found) {
+    bool pending = false;
+    *found = false;
+
+    for (uint32_t offset = 1; offset < worker->count; offset++) {
+        xworker *victim = &worker->peers[(worker->id + offset) % worker->count];
+        bool empty = true;
+        if (xdeque_steal(&victim->deque, item, &empty)) {
+            *found = true;
+            return true;
+        }
+        pending = pending || !empty;
+    }
+    return pending;
+} // end of func
+
+// Runs owned cases first, then steals from peers until all deques drain.
+static void xworker_loop(xworker *worker) {
+    xtable *table = &worker->engine->table;
+    size_t index = 0;
+
+    for (;;) {
+        if (!xdeque_pop(&worker->deque, &index)) {
+            bool found = false;
+            if (!xworker_steal(worker, &index, &found)) {
+                break;
+            }
+            if (!found) {
+                continue;
+            }
+        }
+        xtest_run_test(&worker->stats, table, index);
+    }
+    if (worker->id > 0) {
+        xoutput_release();
+    }
+} // end of func
+
+#if defined(_WIN32)
+static DWORD WINAPI xworker_entry(LPVOID arg) {
+    xworker_loop((xworker*)arg);
+    return 0;
+}
+#else
+static void *xworker_entry(void *arg) {
+    xworker_loop((xworker*)arg);
+    return NULL;
+}
+#endif
+
+static bool xthread_start(xthread *thread, xworker *worker) {
+#if defined(_WIN32)
+    *thread = CreateThread(NULL, 0, xworker_entry, worker, 0, NULL);
+    return *thread != NULL;
+#else
+    return pthread_create(thread, NULL, xworker_entry, worker) == 0;
+#endif
+} // end of func
+
+static void xthread_join(xthread thread) {
+#if defined(_WIN32)
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+} // end of func
+
+// Adds a worker scoreboard into the engine totals.
+static void xstats_merge(xstats *into, const xstats *from) {
+    into->passed_count  += from->passed_count;
+    into->failed_count  += from->failed_count;
+    into->ignored_count += from->ignored_count;
+    into->error_count   += from->error_count;
+    into->mark_count    += from->mark_count;
+    into->fish_count    += from->fish_count;
+    into->test_count    += from->test_count;
+    into->total_count   += from->total_count;
+    into->iteration_count += from->iteration_count;
+} // end of func
+
+// ==============================================================================
+// Xtest process isolation
+// ==============================================================================
+
+#if !defined(_WIN32)
+typedef struct {
+    uint64_t index;  // Queue index of the case that finished
+    xstats stats;    // Scoreboard delta produced by that case
+    uint8_t flags;   // XTEST_FLAG_* bits the case ended with
+    uint64_t duration; // Nanoseconds the case took, for --timings
+    xmark_stats mark; // Benchmark summary, its samples follow the record
+} xresult;
+
+typedef struct {
+    pid_t pid;       // Worker process, or zero once reaped
+    int task_fd;     // Parent writes case indices here
+    int result_fd;   // Parent reads xresult records here
+    bool busy;       // A case is in flight on this worker
+    uint64_t index;  // Case currently in flight
+} xprocess;
+
+// Task tag asking a worker to tear down the pool numbered in the low bits
+#define XPROCESS_RELEASE (UINT64_C(1) << 63)
+
+// Writes or reads a whole record, retrying on interrupts and short transfers.
+static bool xpipe_write(int fd, const void *data, size_t size) {
+    const char *cursor = (const char*)data;
+    while (size > 0) {
+        ssize_t done = write(fd, cursor, size);
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+        if (done <= 0) {
+            return false;
+        }
+        cursor += done;
+        size -= (size_t)done;
+    }
+    return true;
+} // end of func
+
+static bool xpipe_read(int fd, void *data, size_t size) {
+    char *cursor = (char*)data;
+    while (size > 0) {
+        ssize_t done = read(fd, cursor, size);
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+        if (done <= 0) {
+            return false;
+        }
+        cursor += done;
+        size -= (size_t)done;
+    }
+    return true;
+} // end of func
+
+// Body of a pre-forked worker: run each index received and stream back the delta.
+static void xprocess_serve(xtable *table, int task_fd, int result_fd) {
+    uint64_t index = 0;
+    while (xpipe_read(task_fd, &index, sizeof(index))) {
+        if (index & XPROCESS_RELEASE) {
+            uint64_t group = index & ~XPROCESS_RELEASE;
+            if (group < table->pool_count) {
+                xpool_finish(&table->pools[group]);
+            }
+            continue;
+        }
+
+        xresult result;
+        memset(&result, 0, sizeof(result));
+        result.index = index;
+
+        xtest_run_test(&result.stats, table, (size_t)index);
+        result.flags = table->flags[index];
+        result.duration = table->durations[index];
+        if (table->marks) {
+            result.mark = table->marks[index];
+        }
+        xoutput_flush();
+        fflush(stdout);
+        if (!xpipe_write(result_fd, &result, sizeof(result))) {
+            break;
+        }
+        if (result.mark.samples > 0 && !xpipe_write(result_fd, result.mark.values, result.mark.samples * sizeof(double))) {
+            break;
+        }
+    }
+    xpool_release(table);
+    xoutput_flush();
+    fflush(stdout);
+    _exit(EXIT_SUCCESS);
+} // end of func
+
+// Stores what a worker reported about a case, reading the samples that trail it.
+static void xprocess_collect(xtable *table, int result_fd, xresult *result) {
+    size_t index = (size_t)result->index;
+    table->flags[index] = result->flags;
+    table->durations[index] = result->duration;
+    if (table->marks == NULL) {
+        return;
+    }
+    xmark_stats *stats = &table->marks[index];
+    free(stats->values);
+    *stats = result->mark;
+    stats->values = NULL;
+    if (stats->samples > 0) {
+        stats->values = (double*)malloc(stats->samples * sizeof(double));
+        if (stats->values == NULL) {
+            xtest_console_err("Error: Memory allocation failed for benchmark samples.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (!xpipe_read(result_fd, stats->values, stats->samples * sizeof(double))) {
+            stats->samples = 0;
+        }
+    }
+} // end of func
+
+// Forks one worker, closing the descriptors that belong to its siblings.
+static bool xprocess_spawn(xtable *table, xprocess *pool, uint32_t count, uint32_t slot) {
+    int task[2];
+    int result[2];
+    if (pipe(task) != 0) {
+        return false;
+    }
+    if (pipe(result) != 0) {
+        close(task[0]);
+        close(task[1]);
+        return false;
+    }
+
+    xoutput_flush();
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(task[0]);
+        close(task[1]);
+        close(result[0]);
+        close(result[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        for (uint32_t other = 0; other < count; other++) {
+            if (other != slot && pool[other].pid > 0) {
+                close(pool[other].task_fd);
+                close(pool[other].result_fd);
+            }
+        }
+        close(task[1]);
+        close(result[0]);
+        xprocess_serve(table, task[0], result[1]);
+    }
+
+    close(task[0]);
+    close(result[1]);
+    pool[slot].pid = pid;
+    pool[slot].task_fd = task[1];
+    pool[slot].result_fd = result[0];
+    pool[slot].busy = false;
+    return true;
+} // end of func
+
+// Closes a worker's pipes and collects its exit status.
+static int xprocess_reap(xprocess *process) {
+    int status = 0;
+    close(process->task_fd);
+    close(process->result_fd);
+    while (waitpid(process->pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    process->pid = 0;
+    process->busy = false;
+    return status;
+} // end of func
+
+// Reports a case whose worker died before sending its result.
+static void xprocess_crashed(xtest *test_case, int status) {
+    const char *cause = WIFSIGNALED(status)? "terminated by signal" : "exited with status";
+    int code = WIFSIGNALED(status)? WTERMSIG(status) : WEXITSTATUS(status);
+
+    if (xcli.verbose && !xcli.cutback) {
+        xtest_console_out(XCOLOR_RED, "[CRASH CASE]\n");
+        xtest_console_out(XCOLOR_RED, "name: %s\n", test_case->name);
+        xtest_console_out(XCOLOR_RED, "message: worker %s %d\n", cause, code);
+    } else if (!xcli.cutback && !xcli.verbose) {
+        xtest_console_out(XCOLOR_RED, "message: %s crashed, worker %s %d\n", test_case->name, cause, code);
+    } else if (xcli.cutback && !xcli.verbose) {
+        xtest_console_out(XCOLOR_RED, "[E]");
+    }
+} // end of func
+
+// Once the last case of a pool is handed out, tells every worker to tear the
+// pool down after its current case instead of holding it until it exits. The
+// parent runs no cases, so its pending counts track cases not yet handed out.
+static void xprocess_release(xtable *table, xprocess *pool, uint32_t count, uint64_t index) {
+    uint32_t group = table->groups[index];
+    if (group == XTEST_NO_POOL || table->pools[group].fixture == NULL || --table->pools[group].pending > 0) {
+        return;
+    }
+    uint64_t task = XPROCESS_RELEASE | group;
+    for (uint32_t slot = 0; slot < count; slot++) {
+        if (pool[slot].pid > 0) {
+            xpipe_write(pool[slot].task_fd, &task, sizeof(task));
+        }
+    }
+} // end of func
+
+// Sends a table index to an idle worker, respawning it if the pipe is gone.
+static bool xprocess_assign(xtable *table, xprocess *pool, uint32_t count, uint32_t slot, uint64_t index) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (pool[slot].pid > 0 && xpipe_write(pool[slot].task_fd, &index, sizeof(index))) {
+            pool[slot].busy = true;
+            pool[slot].index = index;
+            xprocess_release(table, pool, count, index);
+            return true;
+        }
+        if (pool[slot].pid > 0) {
+            xprocess_reap(&pool[slot]);
+        }
+        if (!xprocess_spawn(table, pool, count, slot)) {
+            return false;
+        }
+    }
+    return false;
+} // end of func
+
+// Runs the selected cases on a pool of long-lived child processes fed over pipes.
+static bool xengine_dispatch_isolated(xengine *engine, uint32_t count) {
+    xtable *table = &engine->table;
+    xprocess *pool = (xprocess*)calloc(count, sizeof(xprocess));
+    struct pollfd *polls = (struct pollfd*)calloc(count, sizeof(struct pollfd));
+    if (pool == NULL || polls == NULL) {
+        free(pool);
+        free(polls);
+        return false;
+    }
+
+    // A worker dying mid-write must not take the runner down with SIGPIPE
+    void (*previous)(int) = signal(SIGPIPE, SIG_IGN);
+
+    uint32_t live = 0;
+    for (uint32_t slot = 0; slot < count; slot++) {
+        live += xprocess_spawn(table, pool, count, slot)? 1 : 0;
+    }
+    if (live == 0) {
+        signal(SIGPIPE, previous);
+        free(pool);
+        free(polls);
+        return false;
+    }
+
+    uint64_t next = 0;
+    uint64_t pending = 0;
+    for (uint32_t slot = 0; slot < count && next < table->selected; slot++) {
+        if (pool[slot].pid > 0 && xprocess_assign(table, pool, count, slot, table->order[next])) {
+            next++;
+            pending++;
+        }
+    }
+
+    while (pending > 0) {
+        for (uint32_t slot = 0; slot < count; slot++) {
+            polls[slot].fd = pool[slot].busy? pool[slot].result_fd : -1;
+            polls[slot].events = POLLIN;
+            polls[slot].revents = 0;
+        }
+        if (poll(polls, count, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (uint32_t slot = 0; slot < count; slot++) {
+            if (!pool[slot].busy || polls[slot].revents == 0) {
+                continue;
+            }
+
+            xresult result;
+            if (xpipe_read(pool[slot].result_fd, &result, sizeof(result))) {
+                xstats_merge(&engine->stats, &result.stats);
+                xprocess_collect(table, pool[slot].result_fd, &result);
+                pool[slot].busy = false;
+            } else {
+                int status = xprocess_reap(&pool[slot]);
+                xprocess_crashed(table->cases[pool[slot].index], status);
+                table->flags[pool[slot].index] |= XTEST_FLAG_ERRORED;
+                engine->stats.error_count++;
+                if (next < table->selected && !xprocess_spawn(table, pool, count, slot)) {
+                    pool[slot].pid = 0;
+                }
+            }
+            pending--;
+
+            if (next < table->selected && pool[slot].pid > 0 && xprocess_assign(table, pool, count, slot, table->order[next])) {
+                next++;
+                pending++;
+            }
+        }
+
+        // Every worker is gone and none could be respawned
+        if (pending == 0 && next < table->selected) {
+            for (uint32_t slot = 0; slot < count && pending == 0; slot++) {
+                if (xprocess_assign(table, pool, count, slot, table->order[next])) {
+                    next++;
+                    pending++;
+                }
+            }
+            if (pending == 0) {
+                xtest_console_err("Error: unable to start isolated workers, %llu cases not run\n",
+                                  (unsigned long long)(table->selected - next));
+            }
+        }
+    }
+
+    for (uint32_t slot = 0; slot < count; slot++) {
+        if (pool[slot].pid > 0) {
+            xprocess_reap(&pool[slot]);
+        }
+    }
+    signal(SIGPIPE, previous);
+    free(pool);
+    free(polls);
+    return true;
+} // end of func
+#endif
+
+// Reorders the selected cases from recorded durations for --jobs. Isolated
+// workers pull from one queue, so it is sorted longest first; worker threads
+// get one block each, packed by LPT so the blocks take about as long, with the
+// longest case of each block first. Returns where each block ends.
+static size_t *xengine_balance(xtable *table, uint32_t jobs) {
+    size_t count = table->selected;
+    uint32_t bin_count = (xcli.isolate || jobs < 1)? 1 : jobs;
+    uint32_t *bins = (uint32_t*)xtable_column(NULL, (count)? count : 1, sizeof(*bins));
+    size_t *sorted = (size_t*)xtable_column(NULL, (count)? count : 1, sizeof(*sorted));
+    size_t *order = (size_t*)xtable_column(NULL, (count)? count : 1, sizeof(*order));
+    size_t *fill = (size_t*)calloc(bin_count + 1, sizeof(*fill));
+    if (fill == NULL) {
+        xtest_console_err("Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    xtable_balance(table, table->order, count, bin_count, bins, sorted);
+
+    // Count each block, turn the counts into offsets, then fill the blocks in
+    // placement order; afterwards every offset sits at the end of its block
+    for (size_t position = 0; position < count; position++) {
+        fill[bins[position] + 1]++;
+    }
+    for (uint32_t bin = 0; bin < bin_count; bin++) {
+        fill[bin + 1] += fill[bin];
+    }
+    for (size_t job = 0; job < count; job++) {
+        size_t position = sorted[job];
+        order[fill[bins[position]]++] = table->order[position];
+    }
+
+    free(table->order);
+    table->order = order;
+    free(bins);
+    free(sorted);
+    return fill;
+} // end of func
+
+// Runs every selected case, fanning out to worker threads when --jobs is above one.
+static void xengine_dispatch_cases(xengine *engine) {
+    xtable *table = &engine->table;
+
+    uint32_t jobs = xcli.jobs;
+    if (jobs > table->selected) {
+        jobs = (uint32_t)table->selected;
+    }
+
+    // With recorded durations, start the longest cases first
+    size_t *ends = NULL;
+    if (xtiming_count > 0 && (jobs > 1 || xcli.isolate) && !xcli.dry_run) {
+        ends = xengine_balance(table, jobs);
+    }
+
+    if (xcli.isolate && !xcli.dry_run && table->selected > 0) {
+#if defined(_WIN32)
+        xtest_console_err("Note: --isolate needs fork(), running cases in-process\n");
+#else
+        if (xengine_dispatch_isolated(engine, (jobs > 1)? jobs : 1)) {
+            free(ends);
+            return;
+        }
+        xtest_console_err("Error: unable to start isolated workers, running cases in-process\n");
+#endif
+    }
+
+    xworker *workers = NULL;
+    xthread *threads = NULL;
+    bool *started = NULL;
+    if (jobs > 1 && !xcli.dry_run) {
+        workers = (xworker*)calloc(jobs, sizeof(xworker));
+        threads = (xthread*)calloc(jobs, sizeof(xthread));
+        started = (bool*)calloc(jobs, sizeof(bool));
+    }
+
+    if (workers == NULL || threads == NULL || started == NULL) {
+        free(workers);
+        free(threads);
+        free(started);
+        for (size_t position = 0; position < table->selected; position++) {
+            xtest_run_test(&engine->stats, table, table->order[position]);
+        }
+        free(ends);
+        return;
+    }
+
+    size_t *items = (size_t*)malloc(table->selected * sizeof(size_t));
+    if (items == NULL) {
+        xtest_console_err("Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Hand each worker a contiguous block, stored reversed so the owner pops
+    // cases in run order while thieves take from the far end of the block
+    size_t block = (table->selected + jobs - 1) / jobs;
+    for (uint32_t id = 0; id < jobs; id++) {
+        size_t first = ((size_t)id * block < table->selected)? (size_t)id * block : table->selected;
+        size_t last = (first + block < table->selected)? first + block : table->selected;
+        if (ends != NULL) {
+            first = (id > 0)? ends[id - 1] : 0;
+            last = ends[id];
+        }
+        size_t length = (first < last)? last - first : 0;
+
+        for (size_t slot = 0; slot < length; slot++) {
+            items[first + slot] = table->order[last - 1 - slot];
+        }
+        workers[id].engine = engine;
+        workers[id].peers = workers;
+        workers[id].count = jobs;
+        workers[id].id = id;
+        workers[id].deque.items = items + first;
+        workers[id].deque.top = 0;
+        workers[id].deque.bottom = (int64_t)length;
+    }
+
+    // The calling thread acts as worker zero
+    for (uint32_t id = 1; id < jobs; id++) {
+        started[id] = xthread_start(&threads[id], &workers[id]);
+    }
+    xworker_loop(&workers[0]);
+
+    for (uint32_t id = 0; id < jobs; id++) {
+        if (started[id]) {
+            xthread_join(threads[id]);
+        }
+        xstats_merge(&engine->stats, &workers[id].stats);
+    }
+
+    free(items);
+    free(ends);
+    free(workers);
+    free(threads);
+    free(started);
+} // end of func
+
+// Runs the selection round after round for --repeat-for and --until-failure,
+// until the time box closes, a case fails or the --repeat rounds are done.
+// Later rounds run muted and only name the cases that newly failed; each
+// case is scored once, failed if any of its rounds failed.
+static void xengine_dispatch_rounds(xengine *engine) {
+    xtable *table = &engine->table;
+    const uint8_t broken = XTEST_FLAG_FAILED | XTEST_FLAG_ERRORED;
+    uint64_t deadline = (xcli.repeat_for_ns > 0)? xtime_now() + xcli.repeat_for_ns : UINT64_MAX;
+    uint64_t rounds = (xcli.repeat)? xcli.iter_repeat : UINT64_MAX;
+    uint8_t *before = (uint8_t*)xtable_column(NULL, (table->selected)? table->selected : 1, sizeof(*before));
+    bool stop = false;
+
+    for (xround = 0; xround < rounds && !stop; xround++) {
+        for (size_t position = 0; position < table->selected; position++) {
+            before[position] = table->flags[table->order[position]];
+        }
+        if (xround > 0) {
+            xtable_arm_pools(table);
+        }
+        xengine_dispatch_cases(engine);
+        xctx.hushed = false;
+
+        for (size_t position = 0; position < table->selected; position++) {
+            size_t index = table->order[position];
+            if (!(table->flags[index] & broken)) {
+                continue;
+            }
+            stop = stop || xcli.until_failure;
+            if (xround > 0 && !(before[position] & broken) && !xcli.cutback) {
+                xtest_console_out(XCOLOR_RED, "round: %s failed in round %" PRIu64 "\n",
+                                  xtest_console_name(table->cases[index]->name), xround + 1);
+            }
+        }
+        stop = stop || xtime_now() >= deadline;
+    }
+    free(before);
+
+    uint64_t iterations = engine->stats.iteration_count;
+    engine->stats = (xstats){0};
+    for (size_t position = 0; position < table->selected; position++) {
+        xtest_update_scoreboard(&engine->stats, table->flags[table->order[position]]);
+    }
+    engine->stats.iteration_count = iterations;
+    xround = 0;
+} // end of func
+
+// Selects the cases and runs them inside the global fixture, if any.
+static void xengine_dispatch(xengine *engine) {
+    xtable *table = &engine->table;
+    if (xcli.timings != NULL) {
+        xtiming_load(table, xcli.timings);
+    }
+    xtable_select(table);
+
+    bool wrapped = engine->global && !xcli.dry_run && table->selected > 0;
+    if (wrapped && engine->global->setup) {
+        engine->global->setup();
+    }
+    if ((xcli.repeat_for_ns > 0 || xcli.until_failure) && !xcli.dry_run) {
+        xengine_dispatch_rounds(engine);
+    } else {
+        xengine_dispatch_cases(engine);
+    }
+    if (wrapped && engine->global->teardown) {
+        engine->global->teardown();
+    }
+} // end of func
+
+// ==============================================================================
+// Xmark environment
+// ==============================================================================
+
+// Machine state that decides whether benchmark numbers can be trusted
+typedef struct {
+    uint32_t cores;       // Online cores
+    char governor[32];    // cpufreq governor of the sampling core, empty if unknown
+    int turbo;            // 1 when turbo/boost is on, 0 when off, -1 if unknown
+    bool raised;          // --priority took effect
+    double load;          // One minute load average, negative if unknown
+} xenvironment;
+
+static xenvironment xenv = {0, "", -1, false, -1.0};
+
+// Reads the first word of a sysfs file into buffer; false when it is missing.
+static bool xenv_read(const char *path, char *buffer, size_t size) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+    bool found = fgets(buffer, (int)size, file) != NULL;
+    fclose(file);
+    buffer[strcspn(buffer, " \r\n")] = '\0';
+    return found && buffer[0] != '\0';
+} // end of func
+
+// Checks the requested core, raises the priority and looks for frequency
+// scaling once per run, warning about anything that makes samples drift.
+static void xenv_prepare(void) {
+    if (!xcli.bench) {
+        return;
+    }
+    xenv.cores = xparser_count_cores();
+
+    if (xcli.pin_cpu >= 0) {
+#if defined(__linux__)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || !CPU_ISSET(xcli.pin_cpu, &allowed)) {
+            xtest_console_err("Error: core %d is not available to this process.\n", xcli.pin_cpu);
+            exit(EXIT_FAILURE);
+        }
+#elif defined(_WIN32)
+        if ((uint32_t)xcli.pin_cpu >= xenv.cores || xcli.pin_cpu >= (int32_t)(sizeof(DWORD_PTR) * 8)) {
+            xtest_console_err("Error: core %d is not available to this process.\n", xcli.pin_cpu);
+            exit(EXIT_FAILURE);
+        }
+#else
+        xtest_console_err("Warning: --pin-cpu is not supported on this platform, benchmarks are not pinned\n");
+        xcli.pin_cpu = -1;
+#endif
+    }
+
+    if (xcli.priority) {
+#if defined(_WIN32)
+        xenv.raised = SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS) != 0;
+#else
+        xenv.raised = setpriority(PRIO_PROCESS, 0, -10) == 0;
+#endif
+        if (!xenv.raised) {
+            xtest_console_err("Warning: unable to raise priority, benchmarks run at default priority\n");
+        }
+    }
+
+#if defined(__linux__)
+    char path[128], value[32];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", (xcli.pin_cpu >= 0)? xcli.pin_cpu : 0);
+    if (xenv_read(path, xenv.governor, sizeof(xenv.governor)) && strcmp(xenv.governor, "performance") != 0) {
+        xtest_console_err("Warning: CPU frequency governor is '%s', benchmark timings may drift; use 'performance'\n", xenv.governor);
+    }
+    if (xenv_read("/sys/devices/system/cpu/intel_pstate/no_turbo", value, sizeof(value))) {
+        xenv.turbo = (strcmp(value, "0") == 0);
+    } else if (xenv_read("/sys/devices/system/cpu/cpufreq/boost", value, sizeof(value))) {
+        xenv.turbo = (strcmp(value, "1") == 0);
+    }
+    if (xenv.turbo == 1) {
+        xtest_console_err("Warning: CPU turbo boost is enabled, benchmark timings may vary with temperature\n");
+    }
+#endif
+#if !defined(_WIN32)
+    double load = 0.0;
+    if (getloadavg(&load, 1) == 1) {
+        xenv.load = load;
+    }
+#endif
+} // end of func
+
+// Single line form of the environment, shared by the report and baseline files.
+static const char *xenv_describe(char *buffer, size_t size) {
+    char pin[16], load[16];
+    if (xcli.pin_cpu >= 0) {
+        snprintf(pin, sizeof(pin), "%d", xcli.pin_cpu);
+    } else {
+        strcpy(pin, "none");
+    }
+    if (xenv.load >= 0.0) {
+        snprintf(load, sizeof(load), "%.2f", xenv.load);
+    } else {
+        strcpy(load, "unknown");
+    }
+    snprintf(buffer, size, "cores=%" PRIu32 " pin=%s governor=%s turbo=%s priority=%s load=%s",
+             xenv.cores, pin, xenv.governor[0]? xenv.governor : "unknown",
+             (xenv.turbo < 0)? "unknown" : xenv.turbo? "on" : "off",
+             xenv.raised? "raised" : "default", load);
+    return buffer;
+} // end of func
+
+static void xenv_report(void) {
+    if (!xcli.bench || xcli.cutback) {
+        return;
+    }
+    char line[256];
+    xtest_console_out(XCOLOR_BLUE, "[ ===== Xmark environment ===== ] %s\n", xenv_describe(line, sizeof(line)));
+} // end of func
+
+// Saved affinity of a thread while it samples on the --pin-cpu core
+typedef struct {
+    bool pinned;
+#if defined(__linux__)
+    cpu_set_t previous;
+#elif defined(_WIN32)
+    DWORD_PTR previous;
+#endif
+} xpin;
+
+static void xpin_enter(xpin *pin) {
+    pin->pinned = false;
+    if (xcli.pin_cpu < 0) {
+        return;
+    }
+#if defined(__linux__)
+    cpu_set_t only;
+    CPU_ZERO(&only);
+    CPU_SET(xcli.pin_cpu, &only);
+    pin->pinned = sched_getaffinity(0, sizeof(pin->previous), &pin->previous) == 0
+               && sched_setaffinity(0, sizeof(only), &only) == 0;
+#elif defined(_WIN32)
+    pin->previous = SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << xcli.pin_cpu);
+    pin->pinned = pin->previous != 0;
+#endif
+} // end of func
+
+static void xpin_leave(xpin *pin) {
+    if (!pin->pinned) {
+        return;
+    }
+#if defined(__linux__)
+    sched_setaffinity(0, sizeof(pin->previous), &pin->previous);
+#elif defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), pin->previous);
+#endif
+} // end of func
+
+// ==============================================================================
+// Xmark hardware counters
+// ==============================================================================
+
+// One perf_event_open descriptor per counter of xmark_counters, -1 when unavailable
+typedef struct {
+    int fds[5];
+} xperf;
+
+// Opens the counters for the calling thread only, stopped and user space only
+// so they work under the default perf_event_paranoid setting.
+static void xperf_open(xperf *perf) {
+#if defined(XTEST_HAS_PERF)
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+    } events[5] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+    for (size_t i = 0; i < 5; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        perf->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (perf->fds[i] >= 0) {
+            ioctl(perf->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    for (size_t i = 0; i < 5; i++) {
+        perf->fds[i] = -1;
+    }
+#endif
+} // end of func
+
+// Stops the counters and stores them per call, scaling any the kernel multiplexed.
+static void xperf_close(xperf *perf, xmark_counters *counters, double calls) {
+    double *slots[5] = {
+        &counters->cycles, &counters->instructions, &counters->l1d_misses,
+        &counters->llc_misses, &counters->branch_misses
+    };
+    for (size_t i = 0; i < 5; i++) {
+        *slots[i] = -1.0;
+#if defined(XTEST_HAS_PERF)
+        if (perf->fds[i] < 0) {
+            continue;
+        }
+        ioctl(perf->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t reading[3] = {0, 0, 0}; // value, time enabled, time running
+        if (read(perf->fds[i], reading, sizeof(reading)) == (ssize_t)sizeof(reading) && reading[2] > 0 && calls > 0) {
+            *slots[i] = (double)reading[0] * ((double)reading[1] / (double)reading[2]) / calls;
+        }
+        close(perf->fds[i]);
+#endif
+    }
+} // end of func
+
+// Formats one per-call counter, or n/a when it could not be collected.
+static const char *xperf_format(double value, char *buffer, size_t size) {
+    if (value < 0.0) {
+        snprintf(buffer, size, "n/a");
+    } else {
+        snprintf(buffer, size, "%.1f", value);
+    }
+    return buffer;
+} // end of func
+
+static void xperf_output(const xmark_counters *counters) {
+    char cycles[32], instructions[32], l1d[32], llc[32], branches[32], ipc[32];
+    xperf_format(counters->cycles, cycles, sizeof(cycles));
+    xperf_format(counters->instructions, instructions, sizeof(instructions));
+    xperf_format(counters->l1d_misses, l1d, sizeof(l1d));
+    xperf_format(counters->llc_misses, llc, sizeof(llc));
+    xperf_format(counters->branch_misses, branches, sizeof(branches));
+    if (counters->cycles > 0.0 && counters->instructions >= 0.0) {
+        snprintf(ipc, sizeof(ipc), "%.2f", counters->instructions / counters->cycles);
+    } else {
+        snprintf(ipc, sizeof(ipc), "n/a");
+    }
+
+    if (xcli.verbose && !xcli.cutback) {
+        xtest_console_out(XCOLOR_CYAN, "CYCLES: - %s per call\n", cycles);
+        xtest_console_out(XCOLOR_CYAN, "INSTR : - %s per call (IPC %s)\n", instructions, ipc);
+        xtest_console_out(XCOLOR_CYAN, "L1D MS: - %s per call\n", l1d);
+        xtest_console_out(XCOLOR_CYAN, "LLC MS: - %s per call\n", llc);
+        xtest_console_out(XCOLOR_CYAN, "BR MS : - %s per call\n", branches);
+    } else if (!xcli.cutback && !xcli.verbose) {
+        xtest_console_out(XCOLOR_BLUE, "> perf: - %s cycles %s instr (IPC %s) %s L1d-miss %s LLC-miss %s br-miss per call\n",
+                          cycles, instructions, ipc, l1d, llc, branches);
+    }
+} // end of func
+
+// ==============================================================================
+// Xmark statistical engine
+// ==============================================================================
+
+// Holds an XMARK_* threshold until the samples are summarized, once per call site.
+static void xmark_defer(void (*check)(uint64_t, double), double limit) {
+    for (size_t i = 0; i < xctx.check_count; i++) {
+        if (xctx.checks[i].check == check && xctx.checks[i].limit == limit) {
+            return;
+        }
+    }
+    if (xctx.check_count < XMARK_MAX_CHECKS) {
+        xctx.checks[xctx.check_count++] = (xmark_check){check, limit};
+    }
+} // end of func
+
+// Remembers the first failure raised while output is muted so it can be shown once.
+static void xmark_mute_failure(const char *message, const char *file, int line, const char *func, bool expect) {
+    if (!xctx.quiet || xctx.failure != NULL) {
+        return;
+    }
+    xctx.failure = (message != NULL)? message : "";
+    xctx.failure_file = file;
+    xctx.failure_func = func;
+    xctx.failure_line = line;
+    xctx.failure_expect = expect;
+} // end of func
+
+// Calls the body count times; returns the time spent in its XMARK_START/STOP
+// region when it has one, and the wall time of the loop through wall.
+static uint64_t xmark_invoke(void (*test_function)(void), uint64_t count, uint64_t *wall) {
+    xctx.region_used = false;
+    xctx.region_ns = 0;
+    xctx.depth = 0;
+    xctx.open_count = 0;
+    xctx.open_refused = 0;
+
+    uint64_t start = xtime_now();
+    for (uint64_t i = 0; i < count; i++) {
+        test_function();
+    }
+    *wall = xtime_now() - start;
+    return xctx.region_used? xctx.region_ns : *wall;
+} // end of func
+
+static int xmark_compare(const void *left, const void *right) {
+    double a = *(const double*)left;
+    double b = *(const double*)right;
+    return (a > b) - (a < b);
+} // end of func
+
+// Linear interpolation between the closest ranks of a sorted sample.
+static double xmark_percentile(const double *sorted, size_t count, double fraction) {
+    double rank = fraction * (double)(count - 1);
+    size_t below = (size_t)rank;
+    size_t above = (below + 1 < count)? below + 1 : below;
+    return sorted[below] + (sorted[above] - sorted[below]) * (rank - (double)below);
+} // end of func
+
+// xorshift64*, seeded per case so bootstrap intervals are reproducible.
+static uint64_t xmark_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+} // end of func
+
+// Sorts the samples and fills in the summary, including a 95% bootstrap
+// interval of the median from 1000 resamples.
+static void xmark_summarize(xmark_stats *stats) {
+    size_t count = (size_t)stats->samples;
+    double *values = stats->values;
+    qsort(values, count, sizeof(double), xmark_compare);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    stats->mean = sum / (double)count;
+
+    double squares = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        squares += (values[i] - stats->mean) * (values[i] - stats->mean);
+    }
+    stats->stddev = (count > 1)? sqrt(squares / (double)(count - 1)) : 0.0;
+    stats->min = values[0];
+    stats->max = values[count - 1];
+    stats->median = xmark_percentile(values, count, 0.5);
+    stats->p99 = xmark_percentile(values, count, 0.99);
+    stats->ci_low = stats->ci_high = stats->median;
+
+    enum { XMARK_RESAMPLES = 1000 };
+    double *resample = (double*)malloc(count * sizeof(double));
+    double *medians = (double*)malloc(XMARK_RESAMPLES * sizeof(double));
+    if (resample != NULL && medians != NULL) {
+        uint64_t state = 0x9E3779B97F4A7C15ULL ^ stats->iterations;
+        for (size_t round = 0; round < XMARK_RESAMPLES; round++) {
+            for (size_t i = 0; i < count; i++) {
+                resample[i] = values[xmark_random(&state) % count];
+            }
+            qsort(resample, count, sizeof(double), xmark_compare);
+            medians[round] = xmark_percentile(resample, count, 0.5);
+        }
+        qsort(medians, XMARK_RESAMPLES, sizeof(double), xmark_compare);
+        stats->ci_low = xmark_percentile(medians, XMARK_RESAMPLES, 0.025);
+        stats->ci_high = xmark_percentile(medians, XMARK_RESAMPLES, 0.975);
+    }
+    free(resample);
+    free(medians);
+} // end of func
+
+// Renders nanoseconds with the largest unit that keeps the value above one.
+static const char *xmark_format_ns(double ns, char *buffer, size_t size) {
+    if (ns < 1e3) {
+        snprintf(buffer, size, "%.1f ns", ns);
+    } else if (ns < 1e6) {
+        snprintf(buffer, size, "%.3f us", ns / 1e3);
+    } else if (ns < 1e9) {
+        snprintf(buffer, size, "%.3f ms", ns / 1e6);
+    } else {
+        snprintf(buffer, size, "%.3f s", ns / 1e9);
+    }
+    return buffer;
+} // end of func
+
+// Renders a per-second rate with a decimal prefix, e.g. 1.250 GB/s.
+static const char *xmark_format_rate(double per_second, const char *unit, char *buffer, size_t size) {
+    static const char *prefixes[] = {"", "k", "M", "G", "T"};
+    size_t prefix = 0;
+    while (per_second >= 1000.0 && prefix < 4) {
+        per_second /= 1000.0;
+        prefix++;
+    }
+    snprintf(buffer, size, "%.3f %s%s/s", per_second, prefixes[prefix], unit);
+    return buffer;
+} // end of func
+
+// Throughput at the median time per call, using whichever amounts the case declared.
+static void xmark_output_rate(const xmark_stats *stats) {
+    if ((stats->bytes <= 0.0 && stats->items <= 0.0) || stats->median <= 0.0) {
+        return;
+    }
+    char bytes[32] = "", items[32] = "";
+    if (stats->bytes > 0.0) {
+        xmark_format_rate(stats->bytes * 1e9 / stats->median, "B", bytes, sizeof(bytes));
+    }
+    if (stats->items > 0.0) {
+        xmark_format_rate(stats->items * 1e9 / stats->median, "items", items, sizeof(items));
+    }
+
+    if (xcli.verbose && !xcli.cutback) {
+        if (stats->bytes > 0.0) {
+            xtest_console_out(XCOLOR_CYAN, "BYTES : - %s (%.0f per call)\n", bytes, stats->bytes);
+        }
+        if (stats->items > 0.0) {
+            xtest_console_out(XCOLOR_CYAN, "ITEMS : - %s (%.0f per call)\n", items, stats->items);
+        }
+    } else if (!xcli.cutback && !xcli.verbose) {
+        xtest_console_out(XCOLOR_BLUE, "> rate: - %s%s%s\n", bytes, (bytes[0] && items[0])? " " : "", items);
+    }
+} // end of func
+
+static void xmark_output_stats(const xmark_stats *stats) {
+    char median[32], low[32], high[32], mean[32], stddev[32], min[32], p99[32];
+    xmark_format_ns(stats->median, median, sizeof(median));
+    xmark_format_ns(stats->ci_low, low, sizeof(low));
+    xmark_format_ns(stats->ci_high, high, sizeof(high));
+    xmark_format_ns(stats->mean, mean, sizeof(mean));
+    xmark_format_ns(stats->stddev, stddev, sizeof(stddev));
+    xmark_format_ns(stats->min, min, sizeof(min));
+    xmark_format_ns(stats->p99, p99, sizeof(p99));
+
+    if (xcli.verbose && !xcli.cutback) {
+        xtest_console_out(XCOLOR_BLUE, "[XMARK STATS]\n");
+        xtest_console_out(XCOLOR_CYAN, "SAMPLE: - %" PRIu64 " x %" PRIu64 " calls\n", stats->samples, stats->iterations);
+        xtest_console_out(XCOLOR_CYAN, "MEDIAN: - %s (95%% CI %s .. %s)\n", median, low, high);
+        xtest_console_out(XCOLOR_CYAN, "MEAN  : - %s\n", mean);
+        xtest_console_out(XCOLOR_CYAN, "STDDEV: - %s\n", stddev);
+        xtest_console_out(XCOLOR_CYAN, "MIN   : - %s\n", min);
+        xtest_console_out(XCOLOR_CYAN, "P99   : - %s\n", p99);
+    } else if (!xcli.cutback && !xcli.verbose) {
+        xtest_console_out(XCOLOR_BLUE, "> mark: - median %s [%s, %s] mean %s sd %s min %s p99 %s (%" PRIu64 " x %" PRIu64 ")\n",
+                          median, low, high, mean, stddev, min, p99, stats->samples, stats->iterations);
+    }
+    xmark_output_rate(stats);
+    if (xcli.perf) {
+        xperf_output(&stats->counters);
+    }
+} // end of func
+
+// Warms up, grows the inner loop until a sample lasts --bench-time and
+// collects --bench-samples samples of the body into stats.
+static void xmark_sample(void (*test_function)(void), xmark_stats *stats) {
+    uint64_t wall = 0;
+    uint64_t warmup = xtime_now();
+    do {
+        xmark_invoke(test_function, 1, &wall);
+    } while (xtime_now() - warmup < xcli.bench_warmup_ns && !xctx.ignored && !xctx.errored);
+
+    // Calibrate on wall time so a small timed region cannot blow up the run
+    uint64_t iterations = 1;
+    while (!xctx.ignored && !xctx.errored) {
+        xmark_invoke(test_function, iterations, &wall);
+        if (wall >= xcli.bench_sample_ns || iterations >= MAX_ITERATIONS) {
+            break;
+        }
+        uint64_t scale = (wall > 0)? xcli.bench_sample_ns / wall + 1 : 10;
+        iterations *= (scale < 2)? 2 : (scale > 10)? 10 : scale;
+    }
+
+    xctx.section_count = 0;
+    free(stats->values);
+    stats->values = (double*)malloc(xcli.bench_samples * sizeof(double));
+    stats->samples = 0;
+    stats->iterations = iterations;
+    stats->counters = (xmark_counters){-1.0, -1.0, -1.0, -1.0, -1.0};
+    stats->bytes = (double)xctx.bytes;
+    stats->items = (double)xctx.items;
+    xperf perf;
+    if (xcli.perf) {
+        xperf_open(&perf);
+    }
+    for (uint32_t sample = 0; stats->values && sample < xcli.bench_samples && !xctx.ignored && !xctx.errored; sample++) {
+        stats->values[sample] = (double)xmark_invoke(test_function, iterations, &wall) / (double)iterations;
+        stats->samples++;
+    }
+    if (xcli.perf) {
+        xperf_close(&perf, &stats->counters, (double)stats->samples * (double)iterations);
+    }
+} // end of func
+
+// Median time per call at each size of an XTEST_MARK_RANGE sweep
+typedef struct {
+    uint64_t sizes[XMARK_MAX_SIZES];
+    double medians[XMARK_MAX_SIZES];
+    size_t count;
+} xmark_sweep;
+
+// Growth models tried by xmark_fit, in order of preference on a tie
+static const char *XMARK_MODELS[] = {"O(1)", "O(n)", "O(n log n)", "O(n^2)"};
+
+static double xmark_model(size_t model, double n) {
+    switch (model) {
+        case 0: return 1.0;
+        case 1: return n;
+        case 2: return n * log2(n > 1.0? n : 2.0);
+        default: return n * n;
+    }
+} // end of func
+
+// Least squares fit of time = coefficient * model(n) for every model; picks the
+// one with the smallest root mean square error, returned relative to the mean time.
+static size_t xmark_fit(const xmark_sweep *sweep, double *coefficient, double *rms) {
+    size_t best = 0;
+    *rms = INFINITY;
+    double mean = 0.0;
+    for (size_t i = 0; i < sweep->count; i++) {
+        mean += sweep->medians[i] / (double)sweep->count;
+    }
+
+    for (size_t model = 0; model < sizeof(XMARK_MODELS) / sizeof(XMARK_MODELS[0]); model++) {
+        double cross = 0.0, squares = 0.0;
+        for (size_t i = 0; i < sweep->count; i++) {
+            double f = xmark_model(model, (double)sweep->sizes[i]);
+            cross += sweep->medians[i] * f;
+            squares += f * f;
+        }
+        double c = cross / squares;
+        double error = 0.0;
+        for (size_t i = 0; i < sweep->count; i++) {
+            double residual = sweep->medians[i] - c * xmark_model(model, (double)sweep->sizes[i]);
+            error += residual * residual;
+        }
+        error = sqrt(error / (double)sweep->count) / mean;
+        if (error < *rms) {
+            *rms = error;
+            *coefficient = c;
+            best = model;
+        }
+    }
+    return best;
+} // end of func
+
+static void xmark_output_sweep(const xmark_sweep *sweep) {
+    char time[32];
+    double coefficient = 0.0, rms = 0.0;
+    size_t model = (sweep->count > 1)? xmark_fit(sweep, &coefficient, &rms) : 0;
+
+    if (xcli.verbose && !xcli.cutback) {
+        xtest_console_out(XCOLOR_BLUE, "[XMARK SWEEP]\n");
+        for (size_t i = 0; i < sweep->count; i++) {
+            xtest_console_out(XCOLOR_CYAN, "SIZE  : - %" PRIu64 ": %s\n", sweep->sizes[i], xmark_format_ns(sweep->medians[i], time, sizeof(time)));
+        }
+        if (sweep->count > 1) {
+            xtest_console_out(XCOLOR_CYAN, "FIT   : - %s, %.4g ns per unit (rms %.1f%%)\n", XMARK_MODELS[model], coefficient, rms * 100.0);
+        }
+    } else if (!xcli.cutback && !xcli.verbose && sweep->count > 1) {
+        xtest_console_out(XCOLOR_BLUE, "> sweep: - %" PRIu64 "..%" PRIu64 " fits %s, %.4g ns per unit (rms %.1f%%)\n",
+                          sweep->sizes[0], sweep->sizes[sweep->count - 1], XMARK_MODELS[model], coefficient, rms * 100.0);
+    }
+} // end of func
+
+// Benchmark counterpart of xtest_run: samples the body, or each size of a
+// sweep, then judges the deferred XMARK_* thresholds against the median
+// instead of a single reading. A sweep keeps the samples of its largest size.
+static void xmark_run(xtable* table, size_t index) {
+    void (*test_function)(void) = table->functions[index];
+    xfixture *fixture = table->fixtures[index];
+    xtest *test_case = table->cases[index];
+    xmark_stats *stats = &table->marks[index];
+    xmark_sweep sweep;
+    sweep.count = 0;
+
+    xtime_start(&test_case->timer);
+    if (fixture && fixture->setup) {
+        fixture->setup();
+    }
+    xctx.quiet = true;
+    xctx.sampling = true;
+    xpin pin;
+    xpin_enter(&pin);
+
+    if (test_case->config.range_max > 0) {
+        XMARK_RANGE_EACH(size, test_case->config) {
+            if (sweep.count == XMARK_MAX_SIZES || xctx.ignored || xctx.errored) {
+                break;
+            }
+            xctx.range_size = size;
+            xmark_sample(test_function, stats);
+            if (stats->samples == 0) {
+                break;
+            }
+            xmark_summarize(stats);
+            sweep.sizes[sweep.count] = size;
+            sweep.medians[sweep.count++] = stats->median;
+        }
+    } else {
+        xmark_sample(test_function, stats);
+    }
+
+    xpin_leave(&pin);
+    xctx.quiet = false;
+    xctx.sampling = false;
+    if (fixture && fixture->teardown) {
+        fixture->teardown();
+    }
+    xtime_stop(&test_case->timer);
+    table->durations[index] = test_case->timer.elapsed;
+
+    if (xctx.failure != NULL) {
+        // Replay the first muted failure through the normal reporting path
+        if (xctx.failure_expect) {
+            xexpect(false, xctx.failure, xctx.failure_file, xctx.failure_line, xctx.failure_func);
+        } else {
+            xctx.assert_pass = true;
+            xassert(false, xctx.failure, xctx.failure_file, xctx.failure_line, xctx.failure_func);
+        }
+    }
+    if (stats->samples == 0) {
+        return;
+    }
+
+    xmark_summarize(stats);
+    xmark_output_stats(stats);
+    if (sweep.count > 0) {
+        xmark_output_sweep(&sweep);
+    }
+    for (size_t i = 0; i < xctx.check_count; i++) {
+        xctx.checks[i].check((uint64_t)stats->median, xctx.checks[i].limit);
+    }
+} // end of func
+
+// ==============================================================================
+// Xmark baseline comparison
+// ==============================================================================
+
+// Layout of a baseline line, named in the file header; files from before the
+// header existed are refused rather than guessed at
+#define XBASELINE_VERSION 1
+
+// Statistics of one benchmark read back from a baseline file
+typedef struct {
+    char name[256];
+    xmark_stats stats;
+} xbaseline;
+
+// Two-sided p-value of the Mann-Whitney U test between two sorted sample sets,
+// using the normal approximation with tie and continuity corrections.
+static double xmark_mann_whitney(const double *left, size_t left_count, const double *right, size_t right_count) {
+    size_t total = left_count + right_count;
+    double rank_sum = 0.0;
+    double ties = 0.0;
+    size_t a = 0, b = 0, rank = 0;
+
+    // Walk both sorted sets as one merged sequence, averaging ranks over ties
+    while (a < left_count || b < right_count) {
+        double value = (b == right_count || (a < left_count && left[a] <= right[b]))? left[a] : right[b];
+        size_t from_left = 0, run = 0;
+        while (a < left_count && left[a] == value) {
+            a++;
+            from_left++;
+        }
+        run = from_left;
+        while (b < right_count && right[b] == value) {
+            b++;
+            run++;
+        }
+        double average = (double)rank + ((double)run + 1.0) / 2.0;
+        rank_sum += average * (double)from_left;
+        ties += (double)run * (double)run * (double)run - (double)run;
+        rank += run;
+    }
+
+    double n1 = (double)left_count, n2 = (double)right_count, n = (double)total;
+    double u = rank_sum - n1 * (n1 + 1.0) / 2.0;
+    double mean = n1 * n2 / 2.0;
+    double variance = n1 * n2 / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0)));
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+    double z = (fabs(u - mean) - 0.5) / sqrt(variance);
+    return (z <= 0.0)? 1.0 : erfc(z / sqrt(2.0));
+} // end of func
+
+// Reads every benchmark recorded by --save-baseline, exiting on a malformed file.
+static xbaseline *xbaseline_load(const char *path, size_t *count) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        xtest_console_err("Error: cannot open baseline file %s.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned version = 0;
+    char header[64];
+    if (fgets(header, sizeof(header), file) == NULL || sscanf(header, "# xtest baseline v%u", &version) != 1) {
+        xtest_console_err("Error: baseline file %s has no '# xtest baseline v%d' header, save it again with --save-baseline.\n",
+                          path, XBASELINE_VERSION);
+        exit(EXIT_FAILURE);
+    }
+    if (version != XBASELINE_VERSION) {
+        xtest_console_err("Error: baseline file %s is format v%u, this build reads v%d.\n", path, version, XBASELINE_VERSION);
+        exit(EXIT_FAILURE);
+    }
+
+    xbaseline *entries = NULL;
+    size_t capacity = 0;
+    *count = 0;
+    xbaseline entry;
+    memset(&entry, 0, sizeof(entry));
+    // Comment lines such as the recorded environment are skipped
+    xfile_skip_comments(file);
+    while (fscanf(file, "%255s %" SCNu64 " %" SCNu64, entry.name, &entry.stats.samples, &entry.stats.iterations) == 3) {
+        if (entry.stats.samples == 0 || entry.stats.samples > MAX_SAMPLES) {
+            xtest_console_err("Error: malformed baseline file %s.\n", path);
+            exit(EXIT_FAILURE);
+        }
+        entry.stats.values = (double*)malloc(entry.stats.samples * sizeof(double));
+        if (entry.stats.values == NULL) {
+            xtest_console_err("Error: Memory allocation failed for baseline.\n");
+            exit(EXIT_FAILURE);
+        }
+        xmark_counters *counters = &entry.stats.counters;
+        if (fscanf(file, "%lf %lf %lf %lf %lf", &counters->cycles, &counters->instructions,
+                   &counters->l1d_misses, &counters->llc_misses, &counters->branch_misses) != 5
+            || fscanf(file, "%lf %lf", &entry.stats.bytes, &entry.stats.items) != 2) {
+            xtest_console_err("Error: malformed baseline file %s.\n", path);
+            exit(EXIT_FAILURE);
+        }
+        for (uint64_t i = 0; i < entry.stats.samples; i++) {
+            if (fscanf(file, "%lf", &entry.stats.values[i]) != 1) {
+                xtest_console_err("Error: malformed baseline file %s.\n", path);
+                exit(EXIT_FAILURE);
+            }
+        }
+        xmark_summarize(&entry.stats);
+
+        if (*count == capacity) {
+            capacity = (capacity == 0)? 16 : capacity * 2;
+            entries = (xbaseline*)xtable_column(entries, capacity, sizeof(xbaseline));
+        }
+        entries[(*count)++] = entry;
+    }
+    fclose(file);
+    return entries;
+} // end of func
+
+// Writes the counters and samples of every benchmark that ran, one line per case.
+static void xbaseline_save(const xtable *table, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        xtest_console_err("Error: cannot write baseline file %s.\n", path);
+        exit(EXIT_FAILURE);
+    }
+    char environment[256];
+    fprintf(file, "# xtest baseline v%d\n", XBASELINE_VERSION);
+    fprintf(file, "# %s\n", xenv_describe(environment, sizeof(environment)));
+    for (size_t i = 0; i < table->selected; i++) {
+        size_t index = table->order[i];
+        const xmark_stats *stats = &table->marks[index];
+        if (stats->samples == 0) {
+            continue;
+        }
+        const xmark_counters *counters = &stats->counters;
+        fprintf(file, "%s %" PRIu64 " %" PRIu64, table->cases[index]->name, stats->samples, stats->iterations);
+        fprintf(file, " %.9g %.9g %.9g %.9g %.9g", counters->cycles, counters->instructions,
+                counters->l1d_misses, counters->llc_misses, counters->branch_misses);
+        fprintf(file, " %.17g %.17g", stats->bytes, stats->items);
+        for (uint64_t sample = 0; sample < stats->samples; sample++) {
+            fprintf(file, " %.9g", stats->values[sample]);
+        }
+        fputc('\n', file);
+    }
+    fclose(file);
+} // end of func
+
+// Scores a benchmark as failed when it is significantly slower than its baseline
+// and its median moved by more than --tolerance percent.
+static void xbaseline_compare(xengine *runner, const char *path) {
+    xtable *table = &runner->table;
+    size_t count = 0;
+    xbaseline *entries = xbaseline_load(path, &count);
+
+    xtest_console_out(XCOLOR_BLUE, "[ ===== Xmark baseline compare ===== ] %s\n", path);
+    for (size_t i = 0; i < table->selected; i++) {
+        size_t index = table->order[i];
+        const xmark_stats *stats = &table->marks[index];
+        const xbaseline *entry = NULL;
+        for (size_t j = 0; j < count && entry == NULL; j++) {
+            entry = (strcmp(entries[j].name, table->cases[index]->name) == 0)? &entries[j] : NULL;
+        }
+        if (stats->samples == 0 || entry == NULL) {
+            continue;
+        }
+
+        double change = (stats->median - entry->stats.median) / entry->stats.median * 100.0;
+        double p = xmark_mann_whitney(stats->values, stats->samples, entry->stats.values, entry->stats.samples);
+        bool significant = p < 0.05 && fabs(change) > xcli.tolerance;
+        bool regressed = significant && change > 0.0;
+
+        if (regressed && !(table->flags[index] & (XTEST_FLAG_FAILED | XTEST_FLAG_IGNORED))) {
+            table->flags[index] |= XTEST_FLAG_FAILED;
+            runner->stats.passed_count--;
+            runner->stats.failed_count++;
+        }
+        if (regressed || !xcli.cutback) {
+            char now[32], then[32];
+            xtest_console_out(regressed? XCOLOR_RED : significant? XCOLOR_GREEN : XCOLOR_GRAY,
+                              "%s: - median %s vs %s (%+.1f%%, p=%.3g) %s\n",
+                              table->cases[index]->name,
+                              xmark_format_ns(stats->median, now, sizeof(now)),
+                              xmark_format_ns(entry->stats.median, then, sizeof(then)),
+                              change, p, regressed? "regressed" : significant? "improved" : "unchanged");
+            if (stats->bytes > 0.0 && entry->stats.bytes > 0.0) {
+                char rate[32], before[32];
+                xtest_console_out(XCOLOR_GRAY, "%s: - throughput %s vs %s\n", table->cases[index]->name,
+                                  xmark_format_rate(stats->bytes * 1e9 / stats->median, "B", rate, sizeof(rate)),
+                                  xmark_format_rate(entry->stats.bytes * 1e9 / entry->stats.median, "B", before, sizeof(before)));
+            } else if (stats->items > 0.0 && entry->stats.items > 0.0) {
+                char rate[32], before[32];
+                xtest_console_out(XCOLOR_GRAY, "%s: - throughput %s vs %s\n", table->cases[index]->name,
+                                  xmark_format_rate(stats->items * 1e9 / stats->median, "items", rate, sizeof(rate)),
+                                  xmark_format_rate(entry->stats.items * 1e9 / entry->stats.median, "items", before, sizeof(before)));
+            }
+            // Instruction counts barely move with machine load, so show them as a steadier signal
+            if (stats->counters.instructions > 0.0 && entry->stats.counters.instructions > 0.0) {
+                double instructions = (stats->counters.instructions - entry->stats.counters.instructions) / entry->stats.counters.instructions * 100.0;
+                xtest_console_out(XCOLOR_GRAY, "%s: - instructions %.1f vs %.1f per call (%+.1f%%)\n",
+                                  table->cases[index]->name, stats->counters.instructions,
+                                  entry->stats.counters.instructions, instructions);
+            }
+        }
+    }
+
+    for (size_t j = 0; j < count; j++) {
+        free(entries[j].stats.values);
+    }
+    free(entries);
+} // end of func
+
+// Runs the baseline options once every case has finished.
+static void xmark_baseline(xengine *runner) {
+    if (runner->table.marks == NULL) {
+        return;
+    }
+    if (xcli.compare_baseline != NULL) {
+        xbaseline_compare(runner, xcli.compare_baseline);
+    }
+    if (xcli.save_baseline != NULL) {
+        xbaseline_save(&runner->table, xcli.save_baseline);
+    }
+} // end of func
+
+// ==============================================================================
+// Xmark functions for benchmarks
+// ==============================================================================
+
+// Amounts processed by one call of the body, turned into rates next to the median.
+void xmark_set_bytes(uint64_t bytes) {
+    xctx.bytes = bytes;
+} // end of func
+
+void xmark_set_items(uint64_t items) {
+    xctx.items = items;
+} // end of func
+
+uint64_t xmark_range_size(void) {
+    return xctx.range_size;
+} // end of func
+
+// Finds the section of a label, adding it on first use so parents list first.
+static xmark_section *xmark_section_find(const char *label, uint32_t depth) {
+    for (size_t i = 0; i < xctx.section_count; i++) {
+        if (strcmp(xctx.sections[i].label, label) == 0) {
+            return &xctx.sections[i];
+        }
+    }
+    if (xctx.section_count == XMARK_MAX_SECTIONS) {
+        return NULL;
+    }
+    xctx.sections[xctx.section_count] = (xmark_section){label, depth, 0, 0};
+    return &xctx.sections[xctx.section_count++];
+} // end of func
+
+// Timers live on the caller's stack, so regions may nest and threads never
+// share state; the depth only decides which regions count towards a sample.
+xmark_timer xmark_timer_start(const char *label) {
+    xmark_timer timer = {0, label, xctx.depth++};
+    if (label != NULL) {
+        xmark_section_find(label, timer.depth);
+    }
+    timer.start = xtime_now();
+    return timer;
+} // end of func
+
+uint64_t xmark_timer_stop(xmark_timer *timer) {
+    uint64_t elapsed = xtime_now() - timer->start;
+    xctx.depth = timer->depth;
+    if (timer->depth == 0) {
+        xctx.region_used = true;
+        xctx.region_ns += elapsed;
+    }
+    xmark_section *section = (timer->label != NULL)? xmark_section_find(timer->label, timer->depth) : NULL;
+    if (section != NULL) {
+        section->calls++;
+        section->ns += elapsed;
+    }
+    return elapsed;
+} // end of func
+
+// A start past XMARK_MAX_DEPTH opens no region and errors the case; its stop
+// returns zero, so the regions that did open still pair up with their stops.
+void xmark_start_benchmark() {
+    if (xctx.open_count == XMARK_MAX_DEPTH) {
+        if (xctx.open_refused++ == 0 && !xctx.errored) {
+            xerrors("XMARK_START_BENCHMARK nested deeper than XMARK_MAX_DEPTH (" XTEST_TEXT(XMARK_MAX_DEPTH) ")",
+                    __FILE__, __LINE__, __func__);
+        }
+        return;
+    }
+    xctx.open[xctx.open_count++] = xmark_timer_start(NULL);
+} // end of func
+
+uint64_t xmark_stop_benchmark() {
+    if (xctx.open_refused > 0) {
+        xctx.open_refused--;
+        return 0;
+    }
+    if (xctx.open_count == 0) {
+        return 0;
+    }
+    return xmark_timer_stop(&xctx.open[--xctx.open_count]);
+} // end of func
+
+void xmark_assert_seconds(uint64_t elapsed_time_ns, double max_seconds) {
+    if (xctx.sampling) {
+        xmark_defer(xmark_assert_seconds, max_seconds);
+        return;
+    }
+    if (!xctx.assert_pass) {
+        return;
+    }
+    double elapsed_seconds = elapsed_time_ns / 1e9;
+    if (elapsed_seconds > max_seconds) {
+        xctx.assert_pass = false;
+        if (xcli.verbose && !xcli.cutback) {
+            xtest_console_out(XCOLOR_BLUE, "[XMARK ISSUE]\n");
+            xtest_console_out(XCOLOR_RED, "Elapsed time (%f min)\n", elapsed_seconds);
+            xtest_console_out(XCOLOR_RED, "Exceeds limit (%f min)\n", max_seconds);
+        } else if (!xcli.cutback && !xcli.verbose) {
+            xtest_console_out(XCOLOR_RED, "Benchmark failed: elapsed time (%f min) exceeds limit (%f min)\n", elapsed_seconds, max_seconds);
+        } else if (xcli.cutback && !xcli.verbose) {
+            xtest_console_out(XCOLOR_RED, "[F]");
+        }
+    } else {
+        if (xcli.cutback && !xcli.verbose) {
+            xtest_console_out(XCOLOR_GREEN, "[P]");
+        }
+    }
+}
 
 void xmark_assert_minutes(uint64_t elapsed_time_ns, double max_minutes) {
-    if (!XASSERT_PASS_SCAN) {
+    if (xctx.sampling) {
+        xmark_defer(xmark_assert_minutes, max_minutes);
+        return;
+    }
+    if (!xctx.assert_pass) {
         return;
     }
     double elapsed_minutes = elapsed_time_ns / 60e9;
     if (elapsed_minutes > max_minutes) {
-         XASSERT_PASS_SCAN = false;
+        xctx.assert_pass = false;
         if (xcli.verbose && !xcli.cutback) {
-            xtest_console_out("blue", "[XMARK ISSUE]\n");
-            xtest_console_out("red", "Elapsed time (%f min)\n", elapsed_minutes);
-            xtest_console_out("red", "Exceeds limit (%f min)\n", max_minutes);
+            xtest_console_out(XCOLOR_BLUE, "[XMARK ISSUE]\n");
+            xtest_console_out(XCOLOR_RED, "Elapsed time (%f min)\n", elapsed_minutes);
+            xtest_console_out(XCOLOR_RED, "Exceeds limit (%f min)\n", max_minutes);
         } else if (!xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "Benchmark failed: elapsed time (%f min) exceeds limit (%f min)\n", elapsed_minutes, max_minutes);
+            xtest_console_out(XCOLOR_RED, "Benchmark failed: elapsed time (%f min) exceeds limit (%f min)\n", elapsed_minutes, max_minutes);
         } else if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "[F]");
+            xtest_console_out(XCOLOR_RED, "[F]");
         }
     } else {
         if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("green", "[P]");
+            xtest_console_out(XCOLOR_GREEN, "[P]");
         }
     }
 }
 
 void xmark_expect_seconds(uint64_t elapsed_time_ns, double max_seconds) {
+    if (xctx.sampling) {
+        xmark_defer(xmark_expect_seconds, max_seconds);
+        return;
+    }
     double elapsed_seconds = elapsed_time_ns / 1e9;
-    XEXPECT_PASS_SCAN = true;
 
     if (elapsed_seconds > max_seconds) {
-        XEXPECT_PASS_SCAN = false;
+        xctx.expect_pass = false;
         if (xcli.verbose && !xcli.cutback) {
-            xtest_console_out("blue", "[XMARK ISSUE]\n");
-            xtest_console_out("red", "Elapsed time (%f min)\n", elapsed_seconds);
-            xtest_console_out("red", "Exceeds limit (%f min)\n", max_seconds);
+            xtest_console_out(XCOLOR_BLUE, "[XMARK ISSUE]\n");
+            xtest_console_out(XCOLOR_RED, "Elapsed time (%f min)\n", elapsed_seconds);
+            xtest_console_out(XCOLOR_RED, "Exceeds limit (%f min)\n", max_seconds);
         } else if (!xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "Benchmark failed: elapsed time (%f min) exceeds limit (%f min)\n", elapsed_seconds, max_seconds);
+            xtest_console_out(XCOLOR_RED, "Benchmark failed: elapsed time (%f min) exceeds limit (%f min)\n", elapsed_seconds, max_seconds);
         } else if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "[F]");
+            xtest_console_out(XCOLOR_RED, "[F]");
         }
     } else {
         if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("green", "[P]");
+            xtest_console_out(XCOLOR_GREEN, "[P]");
         }
     }
 }
 
 void xmark_expect_minutes(uint64_t elapsed_time_ns, double max_minutes) {
+    if (xctx.sampling) {
+        xmark_defer(xmark_expect_minutes, max_minutes);
+        return;
+    }
     double elapsed_minutes = elapsed_time_ns / 60e9;
-    XEXPECT_PASS_SCAN = true;
 
     if (elapsed_minutes > max_minutes) {
-        XEXPECT_PASS_SCAN = false;
+        xctx.expect_pass = false;
         if (xcli.verbose && !xcli.cutback) {
-            xtest_console_out("blue", "[XMARK ISSUE]\n");
-            xtest_console_out("red", "Elapsed time (%f min)\n", elapsed_minutes);
-            xtest_console_out("red", "Exceeds limit (%f min)\n", max_minutes);
+            xtest_console_out(XCOLOR_BLUE, "[XMARK ISSUE]\n");
+            xtest_console_out(XCOLOR_RED, "Elapsed time (%f min)\n", elapsed_minutes);
+            xtest_console_out(XCOLOR_RED, "Exceeds limit (%f min)\n", max_minutes);
         } else if (!xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "Benchmark failed: elapsed time (%f min) exceeds limit (%f min)\n", elapsed_minutes, max_minutes);
+            xtest_console_out(XCOLOR_RED, "Benchmark failed: elapsed time (%f min) exceeds limit (%f min)\n", elapsed_minutes, max_minutes);
         } else if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "[F]");
+            xtest_console_out(XCOLOR_RED, "[F]");
         }
     } else {
         if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("green", "[P]");
+            xtest_console_out(XCOLOR_GREEN, "[P]");
         }
     }
 }
@@ -538,74 +3730,106 @@ void xmark_expect_minutes(uint64_t elapsed_time_ns, double max_minutes) {
 
 // Marks a test case as ignored with a specified reason and prints it to stderr.
 void xignore(const char* reason, const char* file, int line, const char* func) {
-    XIGNORE_TEST_CASE = true;
+    xctx.ignored = true;
     if (xcli.verbose && !xcli.cutback) {
-        xtest_console_out("yellow", "[SKIP CASE]\n");
-        xtest_console_out("yellow", "line: %.4i\nfile: %s\nfunc: %s\n", line, file, func);
-        xtest_console_out("yellow", "message: %s\n", reason);
+        xtest_console_out(XCOLOR_YELLOW, "[SKIP CASE]\n");
+        xtest_console_out(XCOLOR_YELLOW, "line: %.4i\nfile: %s\nfunc: %s\n", line, file, func);
+        xtest_console_out(XCOLOR_YELLOW, "message: %s\n", reason);
     } else if (!xcli.cutback && !xcli.verbose) {
-        xtest_console_out("yellow", "message: %s\n line: %.4i\n func: %s\n", reason, line, func);
+        xtest_console_out(XCOLOR_YELLOW, "message: %s\n line: %.4i\n func: %s\n", reason, line, func);
     } else if (xcli.cutback && !xcli.verbose) {
-        xtest_console_out("yellow", "[S]");
+        xtest_console_out(XCOLOR_YELLOW, "[S]");
     }
 } // end of func
 
 // Marks a test case as error with a specified reason and prints it to stderr.
 void xerrors(const char* reason, const char* file, int line, const char* func) {
-    XERRORS_TEST_CASE = true;
+    xctx.errored = true;
     if (xcli.verbose && !xcli.cutback) {
-        xtest_console_out("red", "[ERROR CASE]\n");
-        xtest_console_out("red", "line: %.4i\nfile: %s\nfunc: %s\n", line, file, func);
-        xtest_console_out("red", "message: %s\n", reason);
+        xtest_console_out(XCOLOR_RED, "[ERROR CASE]\n");
+        xtest_console_out(XCOLOR_RED, "line: %.4i\nfile: %s\nfunc: %s\n", line, file, func);
+        xtest_console_out(XCOLOR_RED, "message: %s\n", reason);
     } else if (!xcli.cutback && !xcli.verbose) {
-        xtest_console_out("red", "message: %s\n line: %.4i\n func: %s\n", reason, line, func);
+        xtest_console_out(XCOLOR_RED, "message: %s\n line: %.4i\n func: %s\n", reason, line, func);
     } else if (xcli.cutback && !xcli.verbose) {
-        xtest_console_out("red", "[E]");
+        xtest_console_out(XCOLOR_RED, "[E]");
     }
 } // end of func
 
 
 // Custom assertion function with optional message.
 void xassert(bool expression, const char *message, const char* file, int line, const char* func) {
-    if (!XASSERT_PASS_SCAN) {
+    if (!xctx.assert_pass) {
+        return;
+    }
+    if (xctx.checking) { // scored by xtest_failure_end
+        xctx.assert_pass = expression;
         return;
     }
     if (!expression) {
-         XASSERT_PASS_SCAN = false;
+        xctx.assert_pass = false;
+        xmark_mute_failure(message, file, line, func, false);
         if (xcli.verbose && !xcli.cutback) {
-            xtest_console_out("blue", "[ASSERT ISSUE]\n");
-            xtest_console_out("red", "line: %.4i\nfile: %s\nfunc: %s\n", line, file, func);
-            xtest_console_out("red", "message: %s\n", message);
+            xtest_console_out(XCOLOR_BLUE, "[ASSERT ISSUE]\n");
+            xtest_console_out(XCOLOR_RED, "line: %.4i\nfile: %s\nfunc: %s\n", line, file, func);
+            xtest_console_out(XCOLOR_RED, "message: %s\n", message);
         } else if (!xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "message: %s\n line: %.4i\n func: %s\n", message, line, func);
+            xtest_console_out(XCOLOR_RED, "message: %s\n line: %.4i\n func: %s\n", message, line, func);
         } else if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "[F]");
+            xtest_console_out(XCOLOR_RED, "[F]");
         }
     } else {
-        if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("green", "[P]");
+        if (xcli.cutback && !xcli.verbose && xctx.iteration == 0) {
+            xtest_console_out(XCOLOR_GREEN, "[P]");
         }
     }
 } // end of func
 
 // Custom expectation function with optional message.
 void xexpect(bool expression, const char *message, const char* file, int line, const char* func) {
-    XEXPECT_PASS_SCAN = true;
-
+    if (xctx.checking) { // scored by xtest_failure_end
+        xctx.expect_pass = expression;
+        return;
+    }
     if (!expression) {
-        XEXPECT_PASS_SCAN = false;
-        if (xcli.verbose && !xcli.cutback) {
-            xtest_console_out("blue", "[EXPECT ISSUE]\n");
-            xtest_console_out("red", "line: %.4i\nfile: %s\nfunc: %s\n", line, file, func);
-            xtest_console_out("red", "message: %s\n", message);
+        // A repeated case reports only the first failing iteration
+        bool first = xctx.expect_pass || xctx.iteration == 0;
+        xctx.expect_pass = false;
+        xmark_mute_failure(message, file, line, func, true);
+        if (!first) {
+            return;
+        } else if (xcli.verbose && !xcli.cutback) {
+            xtest_console_out(XCOLOR_BLUE, "[EXPECT ISSUE]\n");
+            xtest_console_out(XCOLOR_RED, "line: %.4i\nfile: %s\nfunc: %s\n", line, file, func);
+            xtest_console_out(XCOLOR_RED, "message: %s\n", message);
         } else if (!xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "message: %s\n line: %.4i\n func: %s\n", message, line, func);
+            xtest_console_out(XCOLOR_RED, "message: %s\n line: %.4i\n func: %s\n", message, line, func);
         } else if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("red", "[F]");
+            xtest_console_out(XCOLOR_RED, "[F]");
         }
     } else {
-        if (xcli.cutback && !xcli.verbose) {
-            xtest_console_out("green", "[P]");
+        if (xcli.cutback && !xcli.verbose && xctx.iteration == 0) {
+            xtest_console_out(XCOLOR_GREEN, "[P]");
         }
     }
 } // end of func
+
+// Starts a check that is meant to fail. The pass flags are set aside so the
+// check is scored on its own, and its console output is muted.
+void xtest_failure_begin(void) {
+    xctx.held_assert = xctx.assert_pass;
+    xctx.held_expect = xctx.expect_pass;
+    xctx.assert_pass = true;
+    xctx.expect_pass = true;
+    xctx.checking = true;
+} // end of func
+
+// Ends the check started by xtest_failure_begin, restores the pass flags and
+// tells whether the check failed.
+bool xtest_failure_end(void) {
+    bool failed = !xctx.assert_pass || !xctx.expect_pass;
+    xctx.assert_pass = xctx.held_assert;
+    xctx.expect_pass = xctx.held_expect;
+    xctx.checking = false;
+    return failed;
+} // end of func
@@ -22,6 +22,9 @@ Description:
     @return Void
 */
 void bubble_sort(int *array, size_t size) {
+    if (size < 2) {
+        return;
+    }
     for (size_t i = 0; i < size - 1; ++i) {
 
         for (size_t j = 0; j < size - i - 1; ++j) {
@@ -41,108 +44,112 @@ void bubble_sort(int *array, size_t size) {
 //
 // XUNIT-TEST:
 //
-XTEST_MARK(comput_bubble_sort_small_dataset) {
-    XMARK_START_BENCHMARK();
+XTEST_MARK(comput_bubble_sort_timed_sections) {
+    xmark_timer total = XMARK_TIMER_START("total");
 
-    // Example data
-    int data[] = {5, 2, 8, 12, 3};
+    xmark_timer setup = XMARK_TIMER_START("setup");
+    int data[64];
     size_t size = sizeof(data) / sizeof(data[0]);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (int)(size - i);
+    }
+    XMARK_TIMER_STOP(setup);
 
+    xmark_timer kernel = XMARK_TIMER_START("kernel");
     bubble_sort(data, size);
+    XMARK_TIMER_STOP(kernel);
 
-    // Add assertions to check if data is sorted in ascending order
+    xmark_timer verify = XMARK_TIMER_START("verify");
     for (size_t i = 0; i < size - 1; i++) {
         TEST_ASSERT_MSG(data[i] <= data[i + 1], "Data is not sorted");
     }
+    XMARK_TIMER_STOP(verify);
 
-    uint64_t elapsed_time = XMARK_STOP_BENCHMARK();
+    uint64_t elapsed_time = XMARK_TIMER_STOP(total);
     XMARK_ASSERT_SECONDS(elapsed_time, 1.0);
 } // end benchmark
 
-XTEST_MARK(comput_bubble_sort_large_dataset) {
-    XMARK_START_BENCHMARK();
-
-    // Example data
-    int data[] = {100, 75, 43, 28, 56, 89, 34, 12};
+XTEST_MARK(comput_bubble_sort_throughput) {
+    int data[256];
     size_t size = sizeof(data) / sizeof(data[0]);
-
-    bubble_sort(data, size);
-
-    // Add assertions to check if data is sorted in ascending order
-    for (size_t i = 0; i < size - 1; i++) {
-        TEST_ASSERT_MSG(data[i] <= data[i + 1], "Data is not sorted");
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (int)((i * 7919) % size);
     }
+    XMARK_SET_BYTES(sizeof(data));
+    XMARK_SET_ITEMS(size);
 
+    XMARK_START_BENCHMARK();
+    bubble_sort(data, size);
     uint64_t elapsed_time = XMARK_STOP_BENCHMARK();
+
+    TEST_ASSERT_MSG(data[0] <= data[size - 1], "Data is not sorted");
     XMARK_ASSERT_SECONDS(elapsed_time, 1.0);
 } // end benchmark
 
-XTEST_MARK(comput_bubble_sort_medium_dataset) {
-    XMARK_START_BENCHMARK();
-
-    // Example data
-    int data[] = {9, 8, 7, 6, 5, 4, 3, 2, 1};
-    size_t size = sizeof(data) / sizeof(data[0]);
+// Worst case: reverse sorted input, from a single element up
+XTEST_MARK_RANGE(comput_bubble_sort_sweep, 1, 1024) {
+    size_t size = (size_t)XMARK_RANGE_SIZE();
+    int *data = (int*)malloc(size * sizeof(int));
+    TEST_ASSERT_MSG(data != NULL, "Data could not be allocated");
+    if (data == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (int)(size - i);
+    }
+    XMARK_SET_ITEMS(size);
 
+    XMARK_START_BENCHMARK();
     bubble_sort(data, size);
+    uint64_t elapsed_time = XMARK_STOP_BENCHMARK();
 
-    // Add assertions to check if data is sorted in ascending order
-    for (size_t i = 0; i < size - 1; i++) {
+    for (size_t i = 0; i + 1 < size; i++) {
         TEST_ASSERT_MSG(data[i] <= data[i + 1], "Data is not sorted");
     }
-
-    uint64_t elapsed_time = XMARK_STOP_BENCHMARK();
+    free(data);
     XMARK_ASSERT_SECONDS(elapsed_time, 1.0);
 } // end benchmark
 
-XTEST_MARK(comput_bubble_sort_empty_dataset) {
-    XMARK_START_BENCHMARK();
-
-    // Edge case: Empty dataset
-    int data[] = {};
-    size_t size = 0;
-
-    bubble_sort(data, size);
-
-    // Nothing to assert for an empty dataset
-
-    uint64_t elapsed_time = XMARK_STOP_BENCHMARK();
-    XMARK_ASSERT_SECONDS(elapsed_time, 1.0);
-} // end benchmark
+// Best case: already sorted input, which must come back unchanged
+XTEST_MARK_RANGE(comput_bubble_sort_sorted_sweep, 1, 1024) {
+    size_t size = (size_t)XMARK_RANGE_SIZE();
+    int *data = (int*)malloc(size * sizeof(int));
+    TEST_ASSERT_MSG(data != NULL, "Data could not be allocated");
+    if (data == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (int)i;
+    }
+    XMARK_SET_ITEMS(size);
 
-XTEST_MARK(comput_bubble_sort_sorted_dataset) {
     XMARK_START_BENCHMARK();
-
-    // Edge case: Already sorted dataset
-    int data[] = {1, 2, 3, 4, 5};
-    size_t size = sizeof(data) / sizeof(data[0]);
-
     bubble_sort(data, size);
+    uint64_t elapsed_time = XMARK_STOP_BENCHMARK();
 
-    // Add assertions to check if data is sorted in ascending order
-    for (size_t i = 0; i < size - 1; i++) {
-        TEST_ASSERT_MSG(data[i] <= data[i + 1], "Data is not sorted");
+    for (size_t i = 0; i < size; i++) {
+        TEST_ASSERT_MSG(data[i] == (int)i, "Sorted data was reordered");
     }
-
-    uint64_t elapsed_time = XMARK_STOP_BENCHMARK();
+    free(data);
     XMARK_ASSERT_SECONDS(elapsed_time, 1.0);
 } // end benchmark
 
-XTEST_MARK(comput_bubble_sort_reverse_sorted_dataset) {
-    XMARK_START_BENCHMARK();
-
-    // Edge case: Reverse sorted dataset
-    int data[] = {5, 4, 3, 2, 1};
-    size_t size = sizeof(data) / sizeof(data[0]);
-
-    bubble_sort(data, size);
-
-    // Add assertions to check if data is sorted in ascending order
-    for (size_t i = 0; i < size - 1; i++) {
-        TEST_ASSERT_MSG(data[i] <= data[i + 1], "Data is not sorted");
+XTEST_MARK(comput_sum_kept_alive) {
+    int data[512];
+    for (size_t i = 0; i < sizeof(data) / sizeof(data[0]); i++) {
+        data[i] = (int)i;
     }
+    XMARK_ESCAPE(data);
 
+    XMARK_START_BENCHMARK();
+    long sum = 0;
+    for (size_t i = 0; i < sizeof(data) / sizeof(data[0]); i++) {
+        sum += data[i];
+    }
+    XMARK_DO_NOT_OPTIMIZE(sum);
+    XMARK_CLOBBER_MEMORY();
     uint64_t elapsed_time = XMARK_STOP_BENCHMARK();
+
     XMARK_ASSERT_SECONDS(elapsed_time, 1.0);
 } // end benchmark
 
@@ -150,10 +157,9 @@ XTEST_MARK(comput_bubble_sort_reverse_sorted_dataset) {
 // XUNIT-GROUP:
 //
 XTEST_DEFINE_POOL(xbenchs_test_group) {
-    XTEST_RUN_UNIT(comput_bubble_sort_small_dataset);
-    XTEST_RUN_UNIT(comput_bubble_sort_medium_dataset);
-    XTEST_RUN_UNIT(comput_bubble_sort_large_dataset);
-    XTEST_RUN_UNIT(comput_bubble_sort_empty_dataset);
-    XTEST_RUN_UNIT(comput_bubble_sort_sorted_dataset);
-    XTEST_RUN_UNIT(comput_bubble_sort_reverse_sorted_dataset);
+    XTEST_RUN_UNIT(comput_bubble_sort_timed_sections);
+    XTEST_RUN_UNIT(comput_bubble_sort_throughput);
+    XTEST_RUN_UNIT(comput_bubble_sort_sweep);
+    XTEST_RUN_UNIT(comput_bubble_sort_sorted_sweep);
+    XTEST_RUN_UNIT(comput_sum_kept_alive);
 } // end of group
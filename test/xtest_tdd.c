@@ -13,9 +13,35 @@ Description:
 #include <fossil/xtest.h>
 #include <fossil/xassert.h>
 
+//
+// TEST FIXTURE: set up once for the whole pool
+//
+static int tdd_pool_setups = 0;
+static int tdd_pool_teardowns = 0;
+static bool tdd_pool_live = false;
+
+XTEST_FIXTURE(tdd_pool_fixture);
+XTEST_SETUP(tdd_pool_fixture) {
+    tdd_pool_setups++;
+    tdd_pool_live = true;
+}
+
+XTEST_TEARDOWN(tdd_pool_fixture) {
+    tdd_pool_teardowns++;
+    tdd_pool_live = false;
+}
+
 //
 // TEST CASES
 //
+XTEST_CASE(xassert_run_of_pool_fixture) {
+    // Runners without pools never call it, pools set it up once per round
+    if (tdd_pool_setups > 0) {
+        TEST_ASSERT_MSG(tdd_pool_live, "Pool fixture is not set up while its case runs");
+        TEST_ASSERT_MSG(tdd_pool_setups == tdd_pool_teardowns + 1, "Pool fixture was set up more than once");
+    }
+} // end case
+
 XTEST_CASE(xassert_run_of_int) {
     int x = 42;
     int y = 20;
@@ -85,6 +111,8 @@ XTEST_CASE(xassert_run_of_int64) {
 // XUNIT-GROUP:
 //
 XTEST_DEFINE_POOL(tdd_test_group) {
+    XTEST_POOL_FIXTURE(tdd_pool_fixture);
+    XTEST_RUN_UNIT(xassert_run_of_pool_fixture);
     XTEST_RUN_UNIT(xassert_run_of_int);
     XTEST_RUN_UNIT(xassert_run_of_int8);
     XTEST_RUN_UNIT(xassert_run_of_int16);
@@ -0,0 +1,66 @@
+/*
+==============================================================================
+Author: Michael Gene Brockus (Dreamer)
+Email: michaelbrockus@gmail.com
+Organization: Fossil Logic
+Description: 
+    This file is part of the Fossil Logic project, where innovation meets
+    excellence in software development. Michael Gene Brockus, also known as
+    "Dreamer," is a dedicated contributor to this project. For any inquiries,
+    feel free to contact Michael at michaelbrockus@gmail.com.
+==============================================================================
+*/
+#include <fossil/xtest.h>
+#include <fossil/xassert.h>
+#include <stdlib.h>
+
+//
+// TEST CASES: a crash and a refused benchmark region between passing cases,
+// only run under --isolate
+//
+XTEST_CASE(crash_before) {
+    TEST_ASSERT_MSG(true, "Case before the crash failed");
+} // end case
+
+XTEST_CASE(crash_now) {
+    abort();
+} // end case
+
+XTEST_CASE(crash_deep_regions) {
+    // The seventeenth nested region is refused and errors the case, yet
+    // every stop still pairs up with its start
+    uint64_t elapsed[17];
+    for (int level = 0; level < 17; level++) {
+        XMARK_START_BENCHMARK();
+    }
+    for (int level = 16; level >= 0; level--) {
+        elapsed[level] = XMARK_STOP_BENCHMARK();
+    }
+    TEST_ASSERT_MSG(elapsed[16] == 0, "Refused region reported a time");
+    TEST_ASSERT_MSG(elapsed[0] >= elapsed[15], "Outer region ended before an inner one");
+} // end case
+
+XTEST_CASE(crash_after) {
+    // With one worker this runs only if the crashed worker was replaced
+    TEST_ASSERT_MSG(true, "Case after the crash failed");
+} // end case
+
+XTEST_DEFINE_POOL(crash_test_group) {
+    XTEST_RUN_UNIT(crash_before);
+    XTEST_RUN_UNIT(crash_now);
+    XTEST_RUN_UNIT(crash_deep_regions);
+    XTEST_RUN_UNIT(crash_after);
+} // end of fixture
+
+//
+// XUNIT-TEST RUNNER: each goes down as one error and the run goes on
+//
+int main(int argc, char **argv) {
+    XTEST_CREATE(argc, argv);
+
+    XTEST_IMPORT_POOL(crash_test_group);
+
+    int failed = XTEST_ERASE();
+    bool contained = runner.stats.error_count == 2 && runner.stats.passed_count == 2;
+    return (failed == 0 && contained)? 0 : 1;
+} // end of func
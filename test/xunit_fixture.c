@@ -0,0 +1,86 @@
+/*
+==============================================================================
+Author: Michael Gene Brockus (Dreamer)
+Email: michaelbrockus@gmail.com
+Organization: Fossil Logic
+Description: 
+    This file is part of the Fossil Logic project, where innovation meets
+    excellence in software development. Michael Gene Brockus, also known as
+    "Dreamer," is a dedicated contributor to this project. For any inquiries,
+    feel free to contact Michael at michaelbrockus@gmail.com.
+==============================================================================
+*/
+#include <fossil/xtest.h>
+#include <fossil/xassert.h>
+
+//
+// TEST FIXTURES: one around the whole run, one for the first pool only
+//
+static int global_setups = 0;
+static int global_teardowns = 0;
+static bool global_live = false;
+static bool first_live = false;
+
+XTEST_FIXTURE(run_fixture);
+XTEST_SETUP(run_fixture) {
+    global_setups++;
+    global_live = true;
+}
+
+XTEST_TEARDOWN(run_fixture) {
+    global_teardowns++;
+    global_live = false;
+}
+
+XTEST_FIXTURE(first_fixture);
+XTEST_SETUP(first_fixture) {
+    first_live = true;
+}
+
+XTEST_TEARDOWN(first_fixture) {
+    first_live = false;
+}
+
+//
+// TEST CASES
+//
+XTEST_CASE(fixture_first_opens) {
+    TEST_ASSERT_MSG(global_live, "Global fixture is not set up");
+    TEST_ASSERT_MSG(first_live, "Pool fixture is not set up");
+} // end case
+
+XTEST_CASE(fixture_first_holds) {
+    TEST_ASSERT_MSG(global_live, "Global fixture is not set up");
+    TEST_ASSERT_MSG(first_live, "Pool fixture is not set up");
+} // end case
+
+XTEST_CASE(fixture_second_after) {
+    // The first pool is done by now, even inside an isolated worker that ran it
+    TEST_ASSERT_MSG(global_live, "Global fixture is not set up");
+    TEST_ASSERT_MSG(!first_live, "Pool fixture outlived its last case");
+} // end case
+
+XTEST_DEFINE_POOL(fixture_first_group) {
+    XTEST_POOL_FIXTURE(first_fixture);
+    XTEST_RUN_UNIT(fixture_first_opens);
+    XTEST_RUN_UNIT(fixture_first_holds);
+} // end of fixture
+
+XTEST_DEFINE_POOL(fixture_second_group) {
+    XTEST_RUN_UNIT(fixture_second_after);
+} // end of fixture
+
+//
+// XUNIT-TEST RUNNER: the global fixture wraps the run exactly once
+//
+int main(int argc, char **argv) {
+    XTEST_CREATE(argc, argv);
+
+    XTEST_GLOBAL_FIXTURE(run_fixture);
+    XTEST_IMPORT_POOL(fixture_first_group);
+    XTEST_IMPORT_POOL(fixture_second_group);
+
+    int failed = XTEST_ERASE();
+    bool wrapped = global_setups == 1 && global_teardowns == 1 && !global_live;
+    return (failed == 0 && wrapped && runner.stats.error_count == 0)? 0 : 1;
+} // end of func
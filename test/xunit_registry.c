@@ -0,0 +1,24 @@
+/*
+==============================================================================
+Author: Michael Gene Brockus (Dreamer)
+Email: michaelbrockus@gmail.com
+Organization: Fossil Logic
+Description: 
+    This file is part of the Fossil Logic project, where innovation meets
+    excellence in software development. Michael Gene Brockus, also known as
+    "Dreamer," is a dedicated contributor to this project. For any inquiries,
+    feel free to contact Michael at michaelbrockus@gmail.com.
+==============================================================================
+*/
+#include <fossil/xtest.h>
+
+//
+// XUNIT-TEST RUNNER: discovers every case from the registration section
+//
+int main(int argc, char **argv) {
+    XTEST_CREATE(argc, argv);
+
+    XTEST_IMPORT_ALL();
+
+    return XTEST_ERASE();
+} // end of func
@@ -0,0 +1,69 @@
+/*
+==============================================================================
+Author: Michael Gene Brockus (Dreamer)
+Email: michaelbrockus@gmail.com
+Organization: Fossil Logic
+Description: 
+    This file is part of the Fossil Logic project, where innovation meets
+    excellence in software development. Michael Gene Brockus, also known as
+    "Dreamer," is a dedicated contributor to this project. For any inquiries,
+    feel free to contact Michael at michaelbrockus@gmail.com.
+==============================================================================
+*/
+#include <fossil/xtest.h>
+#include <fossil/xassert.h>
+#include <string.h>
+
+//
+// TEST CASES: one steady case and one that fails on its third run
+//
+static uint64_t steady_runs = 0;
+static uint64_t flaky_runs = 0;
+
+XTEST_CASE(repeat_steady) {
+    steady_runs++;
+    TEST_ASSERT_MSG(steady_runs > 0, "Steady case lost its count");
+} // end case
+
+XTEST_CASE(repeat_flaky) {
+    flaky_runs++;
+    TEST_ASSERT_MSG(flaky_runs != 3, "Flaky case failed on its third run");
+} // end case
+
+XTEST_DEFINE_POOL(repeat_test_group) {
+    XTEST_RUN_UNIT(repeat_steady);
+    XTEST_RUN_UNIT(repeat_flaky);
+} // end of fixture
+
+//
+// XUNIT-TEST RUNNER: checks the counts each repeat mode leaves behind
+//
+int main(int argc, char **argv) {
+    bool until_failure = false;
+    bool repeat_for = false;
+    for (int i = 1; i < argc; i++) {
+        until_failure = until_failure || strcmp(argv[i], "--until-failure") == 0;
+        repeat_for = repeat_for || strcmp(argv[i], "--repeat-for") == 0;
+    }
+
+    XTEST_CREATE(argc, argv);
+
+    XTEST_IMPORT_POOL(repeat_test_group);
+
+    XTEST_ERASE();
+
+    xstats *stats = &runner.stats;
+    bool counted = stats->total_count == 2 && stats->failed_count == 1 &&
+                   stats->iteration_count == steady_runs + flaky_runs;
+    if (until_failure) {
+        // Whole rounds run until the flaky case fails in the third one
+        counted = counted && flaky_runs == 3 && steady_runs == 3;
+    } else if (repeat_for) {
+        // The time box outlasts the third round, so every round runs both cases
+        counted = counted && flaky_runs >= 3 && steady_runs == flaky_runs;
+    } else {
+        // --repeat 4 runs each case four times, ITERATIONS is N x cases
+        counted = counted && stats->iteration_count == 4 * stats->total_count;
+    }
+    return counted? 0 : 1;
+} // end of func